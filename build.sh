@@ -1 +1,16 @@
-g++-mp-4.9 -std=c++11 -fopenmp pain_in_the_nash.cpp -o pain_in_the_nash;
+FLAGS="-std=c++11 -fopenmp -pthread";
+
+if [[ "$1" == "--native" ]]; then
+	# wide vector registers, which --batched needs to be any faster
+	FLAGS="$FLAGS -O3 -march=native -ffp-contract=off";
+	shift;
+fi;
+
+g++-mp-4.9 $FLAGS pain_in_the_nash.cpp -o pain_in_the_nash || exit 1;
+
+if [[ "$1" == "--embed" ]]; then
+	# the rest are the arguments for embed, e.g. --embed 1000 30 15 --stationary
+	shift;
+	./pain_in_the_nash embed "$@" || exit 1;
+	g++-mp-4.9 $FLAGS -DPITN_EMBEDDED pain_in_the_nash.cpp -o pain_in_the_nash;
+fi;
@@ -1,12 +1,172 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 typedef double NumT;
-static const NumT EPSILON = 1e-5;
+
+// Build with -DPITN_TELEMETRY to count which paths the solver takes and time
+// each sweep; generate() then appends a JSON line per turn to
+// nashtelemetry.jsonl (see TelemetryLog). Otherwise TELEMETRY(...) is empty
+#ifdef PITN_TELEMETRY
+#define TELEMETRY(...) __VA_ARGS__
+#else
+#define TELEMETRY(...)
+#endif
+
+#ifdef PITN_TELEMETRY
+enum TelemetryCounter {
+	COUNT_OBVIOUS_WIN,
+	COUNT_OBVIOUS_LOSS,
+	COUNT_OBVIOUS_RELOAD,
+	COUNT_NASH, // 3x3 games given to the scalar solver
+	// the candidate which findBestMe kept, in the order nash() tries them
+	COUNT_BEST_MIXED_33,
+	COUNT_BEST_MIXED_22,
+	COUNT_BEST_PURE = COUNT_BEST_MIXED_22 + 9,
+	COUNT_NO_EQUILIBRIUM,
+	COUNT_BATCHED, // games given to nash_batch (which keeps no candidate index)
+	TELEMETRY_COUNTERS
+};
+
+static const char *const TELEMETRY_COUNTER_NAMES[TELEMETRY_COUNTERS] = {
+	"obvious_win", "obvious_loss", "obvious_reload", "nash",
+	"best_mixed_33",
+	"best_mixed_22_0", "best_mixed_22_1", "best_mixed_22_2",
+	"best_mixed_22_3", "best_mixed_22_4", "best_mixed_22_5",
+	"best_mixed_22_6", "best_mixed_22_7", "best_mixed_22_8",
+	"best_pure", "no_equilibrium", "batched"
+};
+
+enum TelemetryTimer {
+	TIME_NASH,
+	TIME_BATCH,
+	TELEMETRY_TIMERS
+};
+
+static const char *const TELEMETRY_TIMER_NAMES[TELEMETRY_TIMERS] = {"nash_s", "batch_s"};
+
+struct TelemetrySlot {
+	std::uint64_t counts[TELEMETRY_COUNTERS];
+	std::uint64_t nanos[TELEMETRY_TIMERS];
+	char padding[64]; // keeps other threads' slots off this cache line
+
+	void add(const TelemetrySlot &b) {
+		for(int i = 0; i < TELEMETRY_COUNTERS; ++ i) {
+			counts[i] += b.counts[i];
+		}
+		for(int i = 0; i < TELEMETRY_TIMERS; ++ i) {
+			nanos[i] += b.nanos[i];
+		}
+	}
+};
+
+// Every thread's counters. Slots are never freed, so they can still be
+// collected after their thread has gone
+class Telemetry {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<TelemetrySlot>> slots;
+
+public:
+	static Telemetry &global(void) {
+		static Telemetry telemetry;
+		return telemetry;
+	}
+
+	TelemetrySlot *add(void) {
+		std::lock_guard<std::mutex> lock(mutex);
+		slots.push_back(std::unique_ptr<TelemetrySlot>(new TelemetrySlot()));
+		return slots.back().get();
+	}
+
+	// Sums and clears every slot; only call while no other thread is counting
+	TelemetrySlot collect(void) {
+		std::lock_guard<std::mutex> lock(mutex);
+		TelemetrySlot total = TelemetrySlot();
+		for(auto &slot : slots) {
+			total.add(*slot);
+			*slot = TelemetrySlot();
+		}
+		return total;
+	}
+};
+
+inline TelemetrySlot &telemetry(void) {
+	static thread_local TelemetrySlot *slot = Telemetry::global().add();
+	return *slot;
+}
+
+// Adds the time until it goes out of scope to a timer
+class TelemetryScope {
+	TelemetryTimer timer;
+	std::chrono::steady_clock::time_point begin;
+
+public:
+	explicit TelemetryScope(TelemetryTimer timer)
+		: timer(timer)
+		, begin(std::chrono::steady_clock::now())
+	{}
+
+	~TelemetryScope(void) {
+		telemetry().nanos[timer] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - begin
+		).count();
+	}
+};
+#endif
+
+// Tolerances which depend on the precision of the scalar type
+template <typename T>
+struct ScalarLimits;
+
+template <>
+struct ScalarLimits<double> {
+	static constexpr double probability = 1e-5; // how far outside [0, 1] a mixed strategy can be
+	static constexpr double reply = 0; // how much better an unused reply can be
+	static constexpr double pivot = 1e-12; // smallest simplex pivot
+	static constexpr double zeroSum = 1e-9; // largest |me + them| of a zero-sum value
+};
+
+template <>
+struct ScalarLimits<float> {
+	// values are close to +/-1, so differences between them lose most bits
+	static constexpr float probability = 1e-3f;
+	static constexpr float reply = 1e-5f;
+	static constexpr float pivot = 1e-6f;
+	static constexpr float zeroSum = 1e-5f;
+};
 
 struct Index {
 	int me;
@@ -15,26 +175,62 @@ struct Index {
 	Index(int me, int them) : me(me), them(them) {}
 };
 
-struct Value {
-	NumT me;
-	NumT them;
+template <typename T>
+struct BasicValue {
+	T me;
+	T them;
 
-	Value(void) : me(0), them(0) {}
+	// trivial, so that large value arrays can be allocated without touching
+	// them (see FirstTouchAllocator); use Value() for a zero value
+	BasicValue(void) = default;
+
+	BasicValue(T me, T them) : me(me), them(them) {}
+};
+
+typedef BasicValue<NumT> Value;
+
+template <typename T>
+struct FirstTouchAllocator : std::allocator<T> {
+	// Leaves default-constructed elements untouched, so that the sweep can
+	// initialise them in parallel and each page is placed on the NUMA node
+	// of the thread which first writes it
+	template <typename U>
+	struct rebind {
+		typedef FirstTouchAllocator<U> other;
+	};
+
+	FirstTouchAllocator(void) {}
+
+	template <typename U>
+	FirstTouchAllocator(const FirstTouchAllocator<U>&) {}
+
+	template <typename U>
+	void construct(U *p) {
+		::new(static_cast<void*>(p)) U;
+	}
 
-	Value(NumT me, NumT them) : me(me), them(them) {}
+	template <typename U, typename... Args>
+	void construct(U *p, Args&&... args) {
+		::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+	}
 };
 
-template <int subDimMe, int subDimThem>
-struct Game {
-	const std::array<NumT, 9> *valuesMe;
-	const std::array<NumT, 9> *valuesThemT;
+template <typename T>
+using BasicValueVector = std::vector<BasicValue<T>, FirstTouchAllocator<BasicValue<T>>>;
+typedef BasicValueVector<NumT> ValueVector;
+typedef std::vector<char, FirstTouchAllocator<char>> DataVector;
+
+template <typename T, int subDimMe, int subDimThem>
+struct BasicGame {
+	const std::array<T, 9> *valuesMe;
+	const std::array<T, 9> *valuesThemT;
 
 	std::array<int, subDimMe> coordsMe;
 	std::array<int, subDimThem> coordsThem;
 
-	Game(
-		const std::array<NumT, 9> *valuesMe,
-		const std::array<NumT, 9> *valuesThemT
+	BasicGame(
+		const std::array<T, 9> *valuesMe,
+		const std::array<T, 9> *valuesThemT
 	)
 		: valuesMe(valuesMe)
 		, valuesThemT(valuesThemT)
@@ -46,16 +242,16 @@ struct Game {
 		return Index(coordsMe[i.me], coordsThem[i.them]);
 	}
 
-	Value at(Index i) const {
+	BasicValue<T> at(Index i) const {
 		Index i2 = baseIndex(i);
-		return Value(
+		return BasicValue<T>(
 			(*valuesMe)[i2.me * 3 + i2.them],
 			(*valuesThemT)[i2.me + i2.them * 3]
 		);
 	}
 
-	Game<2, 2> subgame22(int me0, int me1, int them0, int them1) const {
-		Game<2, 2> b(valuesMe, valuesThemT);
+	BasicGame<T, 2, 2> subgame22(int me0, int me1, int them0, int them1) const {
+		BasicGame<T, 2, 2> b(valuesMe, valuesThemT);
 		b.coordsMe[0] = coordsMe[me0];
 		b.coordsMe[1] = coordsMe[me1];
 		b.coordsThem[0] = coordsThem[them0];
@@ -64,28 +260,40 @@ struct Game {
 	}
 };
 
-struct Strategy {
-	std::array<NumT, 3> probMe;
-	std::array<NumT, 3> probThem;
-	Value expectedValue;
+template <int dimMe, int dimThem>
+using Game = BasicGame<NumT, dimMe, dimThem>;
+
+template <typename T>
+struct BasicStrategy {
+	std::array<T, 3> probMe;
+	std::array<T, 3> probThem;
+	BasicValue<T> expectedValue;
 	bool valid;
+	TELEMETRY(int source;) // the candidate this came from (see COUNT_BEST_MIXED_33)
 
-	Strategy(void)
+	BasicStrategy(void)
 		: probMe{}
 		, probThem{}
 		, expectedValue()
 		, valid(false)
+		TELEMETRY(, source(0))
 	{}
 
-	void findBestMe(const Strategy &b) {
+	bool findBestMe(const BasicStrategy &b, int source = 0) {
+		(void) source; // (only kept with PITN_TELEMETRY)
 		if(b.valid && (!valid || b.expectedValue.me > expectedValue.me)) {
 			*this = b;
+			TELEMETRY(this->source = source;)
+			return true;
 		}
+		return false;
 	}
 };
 
-template <int dimMe, int dimThem>
-void debugGame(const Game<dimMe, dimThem> &g) {
+typedef BasicStrategy<NumT> Strategy;
+
+template <typename T, int dimMe, int dimThem>
+void debugGame(const BasicGame<T, dimMe, dimThem> &g) {
 	std::cerr << "Subgame " << dimMe << 'x' << dimThem << std::endl;
 	std::cerr << '.';
 	for(int them = 0; them < dimThem; ++ them) {
@@ -104,7 +312,8 @@ void debugGame(const Game<dimMe, dimThem> &g) {
 	std::cerr << std::endl;
 }
 
-void debugStrategy(const Strategy &s) {
+template <typename T>
+void debugStrategy(const BasicStrategy<T> &s) {
 	std::cerr << "Strategy:" << std::endl;
 	std::cerr << "  Me:  ";
 	for(int i = 0; i < s.probMe.size(); ++ i) {
@@ -119,14 +328,14 @@ void debugStrategy(const Strategy &s) {
 	std::cerr << std::endl;
 }
 
-template <int dimMe, int dimThem>
-Strategy nash_pure(const Game<dimMe, dimThem> &g) {
-	Strategy s;
+template <typename T, int dimMe, int dimThem>
+BasicStrategy<T> nash_pure(const BasicGame<T, dimMe, dimThem> &g) {
+	BasicStrategy<T> s;
 	int choiceMe = -1;
 	int choiceThem = 0;
 	for(int me = 0; me < dimMe; ++ me) {
 		for(int them = 0; them < dimThem; ++ them) {
-			const Value &v = g.at(Index(me, them));
+			const BasicValue<T> &v = g.at(Index(me, them));
 			bool valid = true;
 			for(int me2 = 0; me2 < dimMe; ++ me2) {
 				if(g.at(Index(me2, them)).me > v.me) {
@@ -156,15 +365,16 @@ Strategy nash_pure(const Game<dimMe, dimThem> &g) {
 	return s;
 }
 
-Strategy nash_mixed(const Game<2, 2> &g) {
+template <typename T>
+BasicStrategy<T> nash_mixed(const BasicGame<T, 2, 2> &g) {
 	//    P    Q
 	// p a A  b B
 	// q c C  d D
 
-	Value A = g.at(Index(0, 0));
-	Value B = g.at(Index(0, 1));
-	Value C = g.at(Index(1, 0));
-	Value D = g.at(Index(1, 1));
+	BasicValue<T> A = g.at(Index(0, 0));
+	BasicValue<T> B = g.at(Index(0, 1));
+	BasicValue<T> C = g.at(Index(1, 0));
+	BasicValue<T> D = g.at(Index(1, 1));
 
 	// q = 1-p, Q = 1-P
 	// Pick p such that choice of P,Q is arbitrary
@@ -174,17 +384,18 @@ Strategy nash_mixed(const Game<2, 2> &g) {
 	// p*(A+D-B-C) = D-C
 	// p = (D-C) / (A+D-B-C)
 
-	NumT p = (D.them - C.them) / (A.them + D.them - B.them - C.them);
+	T p = (D.them - C.them) / (A.them + D.them - B.them - C.them);
 
 	// P*a+(1-P)*b = P*c+(1-P)*d
 	// P*a+b-P*b = P*c+d-P*d
 	// P*(a+d-b-c) = d-b
 	// P = (d-b) / (a+d-b-c)
 
-	NumT P = (D.me - B.me) / (A.me + D.me - B.me - C.me);
+	T P = (D.me - B.me) / (A.me + D.me - B.me - C.me);
 
-	Strategy s;
-	if(p >= -EPSILON && p <= 1 + EPSILON && P >= -EPSILON && P <= 1 + EPSILON) {
+	const T epsilon = ScalarLimits<T>::probability;
+	BasicStrategy<T> s;
+	if(p >= -epsilon && p <= 1 + epsilon && P >= -epsilon && P <= 1 + epsilon) {
 		if(p <= 0) {
 			p = 0;
 		} else if(p >= 1) {
@@ -201,7 +412,7 @@ Strategy nash_mixed(const Game<2, 2> &g) {
 		s.probMe[iBase1.me] = 1 - p;
 		s.probThem[iBase0.them] = P;
 		s.probThem[iBase1.them] = 1 - P;
-		s.expectedValue = Value(
+		s.expectedValue = BasicValue<T>(
 			P * A.me + (1 - P) * B.me,
 			p * A.them + (1 - p) * C.them
 		);
@@ -210,26 +421,27 @@ Strategy nash_mixed(const Game<2, 2> &g) {
 	return s;
 }
 
-Strategy nash_mixed(const Game<3, 3> &g) {
+template <typename T>
+BasicStrategy<T> nash_mixed(const BasicGame<T, 3, 3> &g) {
 	//    P    Q    R
 	// p a A  b B  c C
 	// q d D  e E  f F
 	// r g G  h H  i I
 
-	Value A = g.at(Index(0, 0));
-	Value B = g.at(Index(0, 1));
-	Value C = g.at(Index(0, 2));
-	Value D = g.at(Index(1, 0));
-	Value E = g.at(Index(1, 1));
-	Value F = g.at(Index(1, 2));
-	Value G = g.at(Index(2, 0));
-	Value H = g.at(Index(2, 1));
-	Value I = g.at(Index(2, 2));
+	BasicValue<T> A = g.at(Index(0, 0));
+	BasicValue<T> B = g.at(Index(0, 1));
+	BasicValue<T> C = g.at(Index(0, 2));
+	BasicValue<T> D = g.at(Index(1, 0));
+	BasicValue<T> E = g.at(Index(1, 1));
+	BasicValue<T> F = g.at(Index(1, 2));
+	BasicValue<T> G = g.at(Index(2, 0));
+	BasicValue<T> H = g.at(Index(2, 1));
+	BasicValue<T> I = g.at(Index(2, 2));
 
 	// r = 1-p-q, R = 1-P-Q
 	// Pick p,q such that choice of P,Q,R is arbitrary
 
-	NumT q = ((
+	T q = ((
 		+ A.them * (I.them-H.them)
 		+ G.them * (B.them-C.them)
 		- B.them*I.them
@@ -239,12 +451,12 @@ Strategy nash_mixed(const Game<3, 3> &g) {
 		(H.them+F.them-E.them-I.them) * (A.them+H.them-G.them-B.them)
 	));
 
-	NumT p = (
+	T p = (
 		((G.them+E.them-D.them-H.them) * q + (H.them-G.them)) /
 		(A.them+H.them-G.them-B.them)
 	);
 
-	NumT Q = ((
+	T Q = ((
 		+ A.me * (I.me-F.me)
 		+ C.me * (D.me-G.me)
 		- D.me*I.me
@@ -254,15 +466,16 @@ Strategy nash_mixed(const Game<3, 3> &g) {
 		(F.me+H.me-E.me-I.me) * (A.me+F.me-C.me-D.me)
 	));
 
-	NumT P = (
+	T P = (
 		((C.me+E.me-B.me-F.me) * Q + (F.me-C.me)) /
 		(A.me+F.me-C.me-D.me)
 	);
 
-	Strategy s;
+	const T epsilon = ScalarLimits<T>::probability;
+	BasicStrategy<T> s;
 	if(
-		p >= -EPSILON && q >= -EPSILON && p + q <= 1 + EPSILON &&
-		P >= -EPSILON && Q >= -EPSILON && P + Q <= 1 + EPSILON
+		p >= -epsilon && q >= -epsilon && p + q <= 1 + epsilon &&
+		P >= -epsilon && Q >= -epsilon && P + Q <= 1 + epsilon
 	) {
 		if(p <= 0) { p = 0; }
 		if(q <= 0) { q = 0; }
@@ -291,7 +504,7 @@ Strategy nash_mixed(const Game<3, 3> &g) {
 		Index iBase2 = g.baseIndex(Index(2, 2));
 		s.probMe[iBase2.me] = 1 - p - q;
 		s.probThem[iBase2.them] = 1 - P - Q;
-		s.expectedValue = Value(
+		s.expectedValue = BasicValue<T>(
 			A.me * P + B.me * Q + C.me * (1 - P - Q),
 			A.them * p + D.them * q + G.them * (1 - p - q)
 		);
@@ -300,19 +513,19 @@ Strategy nash_mixed(const Game<3, 3> &g) {
 	return s;
 }
 
-template <int dimMe, int dimThem>
-Strategy nash_validate(Strategy &&s, const Game<dimMe, dimThem> &g, Index unused) {
+template <typename T, int dimMe, int dimThem>
+BasicStrategy<T> nash_validate(BasicStrategy<T> &&s, const BasicGame<T, dimMe, dimThem> &g, Index unused) {
 	if(!s.valid) {
 		return s;
 	}
 
-	NumT exp;
+	T exp;
 
 	exp = 0;
 	for(int them = 0; them < dimThem; ++ them) {
 		exp += s.probThem[them] * g.at(Index(unused.me, them)).me;
 	}
-	if(exp > s.expectedValue.me) {
+	if(exp > s.expectedValue.me + ScalarLimits<T>::reply) {
 		s.valid = false;
 		return s;
 	}
@@ -321,7 +534,7 @@ Strategy nash_validate(Strategy &&s, const Game<dimMe, dimThem> &g, Index unused
 	for(int me = 0; me < dimMe; ++ me) {
 		exp += s.probMe[me] * g.at(Index(me, unused.them)).them;
 	}
-	if(exp > s.expectedValue.them) {
+	if(exp > s.expectedValue.them + ScalarLimits<T>::reply) {
 		s.valid = false;
 		return s;
 	}
@@ -329,9 +542,11 @@ Strategy nash_validate(Strategy &&s, const Game<dimMe, dimThem> &g, Index unused
 	return s;
 }
 
-Strategy nash(const Game<2, 2> &g, bool verbose) {
-	Strategy s = nash_mixed(g);
+template <typename T>
+BasicStrategy<T> nash(const BasicGame<T, 2, 2> &g, bool verbose) {
+	BasicStrategy<T> s = nash_mixed(g);
 	s.findBestMe(nash_pure(g));
+	TELEMETRY(telemetry().counts[COUNT_NO_EQUILIBRIUM] += !s.valid;)
 	if(!s.valid && verbose) {
 		std::cerr << "No nash equilibrium found!" << std::endl;
 		debugGame(g);
@@ -339,18 +554,20 @@ Strategy nash(const Game<2, 2> &g, bool verbose) {
 	return s;
 }
 
-Strategy nash(const Game<3, 3> &g, bool verbose) {
-	Strategy s = nash_mixed(g);
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(1, 2,  1, 2)), g, Index(0, 0)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(1, 2,  0, 2)), g, Index(0, 1)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(1, 2,  0, 1)), g, Index(0, 2)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 2,  1, 2)), g, Index(1, 0)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 2,  0, 2)), g, Index(1, 1)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 2,  0, 1)), g, Index(1, 2)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 1,  1, 2)), g, Index(2, 0)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 1,  0, 2)), g, Index(2, 1)));
-	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 1,  0, 1)), g, Index(2, 2)));
-	s.findBestMe(nash_pure(g));
+template <typename T>
+BasicStrategy<T> nash(const BasicGame<T, 3, 3> &g, bool verbose) {
+	BasicStrategy<T> s = nash_mixed(g);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(1, 2,  1, 2)), g, Index(0, 0)), 1);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(1, 2,  0, 2)), g, Index(0, 1)), 2);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(1, 2,  0, 1)), g, Index(0, 2)), 3);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 2,  1, 2)), g, Index(1, 0)), 4);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 2,  0, 2)), g, Index(1, 1)), 5);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 2,  0, 1)), g, Index(1, 2)), 6);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 1,  1, 2)), g, Index(2, 0)), 7);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 1,  0, 2)), g, Index(2, 1)), 8);
+	s.findBestMe(nash_validate(nash_mixed(g.subgame22(0, 1,  0, 1)), g, Index(2, 2)), 9);
+	s.findBestMe(nash_pure(g), 10);
+	TELEMETRY(++ telemetry().counts[s.valid ? COUNT_BEST_MIXED_33 + s.source : COUNT_NO_EQUILIBRIUM];)
 	if(!s.valid && verbose) {
 		// theory says this should never happen, but fp precision makes it possible
 		std::cerr << "No nash equilibrium found!" << std::endl;
@@ -359,6 +576,465 @@ Strategy nash(const Game<3, 3> &g, bool verbose) {
 	return s;
 }
 
+// the candidates nash(Game<3, 3>) tries, in order: the full mixed solution,
+// the nine 2x2 subgames (by the unused action of me, then of them), then pure
+static const int NASH_CANDIDATES = 11;
+static const std::uint8_t NO_SUPPORT = 0xFF;
+
+template <typename T>
+BasicStrategy<T> nash_candidate(const BasicGame<T, 3, 3> &g, int candidate) {
+	if(candidate == 0) {
+		return nash_mixed(g);
+	}
+	if(candidate == NASH_CANDIDATES - 1) {
+		return nash_pure(g);
+	}
+	const Index unused((candidate - 1) / 3, (candidate - 1) % 3);
+	return nash_validate(nash_mixed(g.subgame22(
+		unused.me == 0 ? 1 : 0, unused.me == 2 ? 1 : 2,
+		unused.them == 0 ? 1 : 0, unused.them == 2 ? 1 : 2
+	)), g, unused);
+}
+
+// Same as nash(Game<3, 3>), but first tries the candidate in support (the
+// one which won the last time this state was solved), and keeps it if it is
+// still an equilibrium. Only if it isn't are all the candidates tried, and
+// support set to the winner. Where a game has more than one equilibrium, a
+// hit can keep one which nash() would not pick
+template <typename T>
+BasicStrategy<T> nash_cached(const BasicGame<T, 3, 3> &g, bool verbose, std::uint8_t &support, bool &hit) {
+	if(support != NO_SUPPORT) {
+		BasicStrategy<T> s = nash_candidate(g, support);
+		if(s.valid) {
+			TELEMETRY(++ telemetry().counts[COUNT_BEST_MIXED_33 + support];)
+			hit = true;
+			return s;
+		}
+	}
+	hit = false;
+	support = NO_SUPPORT;
+	BasicStrategy<T> s;
+	for(int candidate = 0; candidate < NASH_CANDIDATES; ++ candidate) {
+		if(s.findBestMe(nash_candidate(g, candidate), candidate)) {
+			support = candidate;
+		}
+	}
+	TELEMETRY(++ telemetry().counts[s.valid ? COUNT_BEST_MIXED_33 + s.source : COUNT_NO_EQUILIBRIUM];)
+	if(!s.valid && verbose) {
+		std::cerr << "No nash equilibrium found!" << std::endl;
+		debugGame(g);
+	}
+	return s;
+}
+
+// Batched 3x3 solver: the same candidates and arithmetic as
+// nash(Game<3, 3>), but for N games at once in structure-of-arrays form.
+// Every step is branch-free across lanes (findBestMe becomes a masked
+// select), so the lane loops vectorise; build with -mavx2 or -mavx512f to
+// use wide lanes. Results are bit-for-bit identical to the scalar solver.
+template <int N, typename T = NumT>
+struct GameBatch {
+	T me[9][N];     // me[m * 3 + t][lane]
+	T themT[9][N];  // themT[m + t * 3][lane]
+
+	template <typename U>
+	void set(
+		int lane,
+		const std::array<U, 9> &valuesMe,
+		const std::array<U, 9> &valuesThemT
+	) {
+		for(int k = 0; k < 9; ++ k) {
+			me[k][lane] = valuesMe[k];
+			themT[k][lane] = valuesThemT[k];
+		}
+	}
+
+	void get(
+		int lane,
+		std::array<T, 9> &valuesMe,
+		std::array<T, 9> &valuesThemT
+	) const {
+		for(int k = 0; k < 9; ++ k) {
+			valuesMe[k] = me[k][lane];
+			valuesThemT[k] = themT[k][lane];
+		}
+	}
+};
+
+template <int N, typename T = NumT>
+struct StrategyBatch {
+	T probMe[3][N];
+	T probThem[3][N];
+	T valueMe[N];
+	T valueThem[N];
+	T valid[N]; // 1 or 0; a T so that masks have the same lane width
+
+	void clear(void) {
+		for(int l = 0; l < N; ++ l) {
+			for(int i = 0; i < 3; ++ i) {
+				probMe[i][l] = 0;
+				probThem[i][l] = 0;
+			}
+			valueMe[l] = 0;
+			valueThem[l] = 0;
+			valid[l] = 0;
+		}
+	}
+
+	BasicStrategy<T> lane(int l) const {
+		BasicStrategy<T> s;
+		for(int i = 0; i < 3; ++ i) {
+			s.probMe[i] = probMe[i][l];
+			s.probThem[i] = probThem[i][l];
+		}
+		s.expectedValue = BasicValue<T>(valueMe[l], valueThem[l]);
+		s.valid = (valid[l] != 0);
+		return s;
+	}
+
+	// findBestMe for every lane at once
+	void findBestMe(const StrategyBatch &b) {
+		#pragma omp simd
+		for(int l = 0; l < N; ++ l) {
+			const bool take = (b.valid[l] != 0) & ((valid[l] == 0) | (b.valueMe[l] > valueMe[l]));
+			probMe[0][l] = take ? b.probMe[0][l] : probMe[0][l];
+			probMe[1][l] = take ? b.probMe[1][l] : probMe[1][l];
+			probMe[2][l] = take ? b.probMe[2][l] : probMe[2][l];
+			probThem[0][l] = take ? b.probThem[0][l] : probThem[0][l];
+			probThem[1][l] = take ? b.probThem[1][l] : probThem[1][l];
+			probThem[2][l] = take ? b.probThem[2][l] : probThem[2][l];
+			valueMe[l] = take ? b.valueMe[l] : valueMe[l];
+			valueThem[l] = take ? b.valueThem[l] : valueThem[l];
+			valid[l] = take ? 1 : valid[l];
+		}
+	}
+};
+
+template <int N, typename T>
+void nash_mixed_batch(const GameBatch<N, T> &g, StrategyBatch<N, T> &s) {
+	// see nash_mixed(const Game<3, 3>&) for the derivation
+	#pragma omp simd
+	for(int l = 0; l < N; ++ l) {
+		const BasicValue<T> A(g.me[0][l], g.themT[0][l]);
+		const BasicValue<T> B(g.me[1][l], g.themT[3][l]);
+		const BasicValue<T> C(g.me[2][l], g.themT[6][l]);
+		const BasicValue<T> D(g.me[3][l], g.themT[1][l]);
+		const BasicValue<T> E(g.me[4][l], g.themT[4][l]);
+		const BasicValue<T> F(g.me[5][l], g.themT[7][l]);
+		const BasicValue<T> G(g.me[6][l], g.themT[2][l]);
+		const BasicValue<T> H(g.me[7][l], g.themT[5][l]);
+		const BasicValue<T> I(g.me[8][l], g.themT[8][l]);
+
+		T q = ((
+			+ A.them * (I.them-H.them)
+			+ G.them * (B.them-C.them)
+			- B.them*I.them
+			+ H.them*C.them
+		) / (
+			(G.them+E.them-D.them-H.them) * (B.them+I.them-H.them-C.them) -
+			(H.them+F.them-E.them-I.them) * (A.them+H.them-G.them-B.them)
+		));
+
+		T p = (
+			((G.them+E.them-D.them-H.them) * q + (H.them-G.them)) /
+			(A.them+H.them-G.them-B.them)
+		);
+
+		T Q = ((
+			+ A.me * (I.me-F.me)
+			+ C.me * (D.me-G.me)
+			- D.me*I.me
+			+ F.me*G.me
+		) / (
+			(C.me+E.me-B.me-F.me) * (D.me+I.me-F.me-G.me) -
+			(F.me+H.me-E.me-I.me) * (A.me+F.me-C.me-D.me)
+		));
+
+		T P = (
+			((C.me+E.me-B.me-F.me) * Q + (F.me-C.me)) /
+			(A.me+F.me-C.me-D.me)
+		);
+
+		const T epsilon = ScalarLimits<T>::probability;
+		const bool valid = (
+			(p >= -epsilon) & (q >= -epsilon) & (p + q <= 1 + epsilon) &
+			(P >= -epsilon) & (Q >= -epsilon) & (P + Q <= 1 + epsilon)
+		);
+
+		p = (p <= 0) ? 0 : p;
+		q = (q <= 0) ? 0 : q;
+		P = (P <= 0) ? 0 : P;
+		Q = (Q <= 0) ? 0 : Q;
+		const bool over = (p + q >= 1);
+		const bool pBigger = (p > q);
+		const T p2 = (over & pBigger) ? 1 - q : p;
+		const T q2 = (over & !pBigger) ? 1 - p : q;
+		const bool OVER = (P + Q >= 1);
+		const bool PBigger = (P > Q);
+		const T P2 = (OVER & PBigger) ? 1 - Q : P;
+		const T Q2 = (OVER & !PBigger) ? 1 - P : Q;
+
+		s.probMe[0][l] = valid ? p2 : 0;
+		s.probMe[1][l] = valid ? q2 : 0;
+		s.probMe[2][l] = valid ? 1 - p2 - q2 : 0;
+		s.probThem[0][l] = valid ? P2 : 0;
+		s.probThem[1][l] = valid ? Q2 : 0;
+		s.probThem[2][l] = valid ? 1 - P2 - Q2 : 0;
+		s.valueMe[l] = valid ? A.me * P2 + B.me * Q2 + C.me * (1 - P2 - Q2) : 0;
+		s.valueThem[l] = valid ? A.them * p2 + D.them * q2 + G.them * (1 - p2 - q2) : 0;
+		s.valid[l] = valid ? 1 : 0;
+	}
+}
+
+// nash_validate(nash_mixed(g.subgame22(me0, me1, them0, them1)), g, Index(3-me0-me1, 3-them0-them1))
+// (the subgame is a template parameter so that all indexing is constant)
+template <int me0, int me1, int them0, int them1, int N, typename T>
+void nash_mixed22_batch(const GameBatch<N, T> &g, StrategyBatch<N, T> &s) {
+	const int unusedMe = 3 - me0 - me1;
+	const int unusedThem = 3 - them0 - them1;
+
+	#pragma omp simd
+	for(int l = 0; l < N; ++ l) {
+		const BasicValue<T> A(g.me[me0 * 3 + them0][l], g.themT[me0 + them0 * 3][l]);
+		const BasicValue<T> B(g.me[me0 * 3 + them1][l], g.themT[me0 + them1 * 3][l]);
+		const BasicValue<T> C(g.me[me1 * 3 + them0][l], g.themT[me1 + them0 * 3][l]);
+		const BasicValue<T> D(g.me[me1 * 3 + them1][l], g.themT[me1 + them1 * 3][l]);
+
+		T p = (D.them - C.them) / (A.them + D.them - B.them - C.them);
+		T P = (D.me - B.me) / (A.me + D.me - B.me - C.me);
+		const T epsilon = ScalarLimits<T>::probability;
+
+		const bool valid = (p >= -epsilon) & (p <= 1 + epsilon) & (P >= -epsilon) & (P <= 1 + epsilon);
+		p = (p <= 0) ? 0 : (p >= 1) ? 1 : p;
+		P = (P <= 0) ? 0 : (P >= 1) ? 1 : P;
+
+		const T pMe = valid ? p : 0;
+		const T qMe = valid ? 1 - p : 0;
+		const T pThem = valid ? P : 0;
+		const T qThem = valid ? 1 - P : 0;
+		// (these selects are resolved at compile time)
+		const T probMe0 = (me0 == 0) ? pMe : (me1 == 0) ? qMe : 0;
+		const T probMe1 = (me0 == 1) ? pMe : (me1 == 1) ? qMe : 0;
+		const T probMe2 = (me0 == 2) ? pMe : (me1 == 2) ? qMe : 0;
+		const T probThem0 = (them0 == 0) ? pThem : (them1 == 0) ? qThem : 0;
+		const T probThem1 = (them0 == 1) ? pThem : (them1 == 1) ? qThem : 0;
+		const T probThem2 = (them0 == 2) ? pThem : (them1 == 2) ? qThem : 0;
+		const T valueMe = valid ? P * A.me + (1 - P) * B.me : 0;
+		const T valueThem = valid ? p * A.them + (1 - p) * C.them : 0;
+
+		// nash_validate: the unused row/column must not be a better reply
+		T expMe = 0;
+		expMe += probThem0 * g.me[unusedMe * 3 + 0][l];
+		expMe += probThem1 * g.me[unusedMe * 3 + 1][l];
+		expMe += probThem2 * g.me[unusedMe * 3 + 2][l];
+		T expThem = 0;
+		expThem += probMe0 * g.themT[0 + unusedThem * 3][l];
+		expThem += probMe1 * g.themT[1 + unusedThem * 3][l];
+		expThem += probMe2 * g.themT[2 + unusedThem * 3][l];
+		// (kept as separate NumT masks; combined bools stop GCC vectorising)
+		const T validMe = (expMe > valueMe + ScalarLimits<T>::reply) ? 0 : T(1);
+		const T validThem = (expThem > valueThem + ScalarLimits<T>::reply) ? 0 : T(1);
+
+		s.probMe[0][l] = probMe0;
+		s.probMe[1][l] = probMe1;
+		s.probMe[2][l] = probMe2;
+		s.probThem[0][l] = probThem0;
+		s.probThem[1][l] = probThem1;
+		s.probThem[2][l] = probThem2;
+		s.valueMe[l] = valueMe;
+		s.valueThem[l] = valueThem;
+		s.valid[l] = valid ? validMe * validThem : 0;
+	}
+}
+
+template <int N, typename T>
+void nash_pure_batch(const GameBatch<N, T> &g, StrategyBatch<N, T> &s) {
+	s.clear();
+	for(int me = 0; me < 3; ++ me) {
+		for(int them = 0; them < 3; ++ them) {
+			const T *cellMe = g.me[me * 3 + them];
+			const T *cellThem = g.themT[me + them * 3];
+			const T *column0 = g.me[0 * 3 + them];
+			const T *column1 = g.me[1 * 3 + them];
+			const T *column2 = g.me[2 * 3 + them];
+			const T *row0 = g.themT[me + 0 * 3];
+			const T *row1 = g.themT[me + 1 * 3];
+			const T *row2 = g.themT[me + 2 * 3];
+			const T me0 = (me == 0);
+			const T me1 = (me == 1);
+			const T me2 = (me == 2);
+			const T them0 = (them == 0);
+			const T them1 = (them == 1);
+			const T them2 = (them == 2);
+
+			#pragma omp simd
+			for(int l = 0; l < N; ++ l) {
+				const T vMe = cellMe[l];
+				const T vThem = cellThem[l];
+				const bool valid = (
+					!(column0[l] > vMe) & !(column1[l] > vMe) & !(column2[l] > vMe) &
+					!(row0[l] > vThem) & !(row1[l] > vThem) & !(row2[l] > vThem)
+				);
+				const bool take = valid & ((s.valid[l] == 0) | (vMe > s.valueMe[l]));
+				s.probMe[0][l] = take ? me0 : s.probMe[0][l];
+				s.probMe[1][l] = take ? me1 : s.probMe[1][l];
+				s.probMe[2][l] = take ? me2 : s.probMe[2][l];
+				s.probThem[0][l] = take ? them0 : s.probThem[0][l];
+				s.probThem[1][l] = take ? them1 : s.probThem[1][l];
+				s.probThem[2][l] = take ? them2 : s.probThem[2][l];
+				s.valueMe[l] = take ? vMe : s.valueMe[l];
+				s.valueThem[l] = take ? vThem : s.valueThem[l];
+				s.valid[l] = take ? 1 : s.valid[l];
+			}
+		}
+	}
+}
+
+template <int N, typename T>
+void nash_batch(const GameBatch<N, T> &g, StrategyBatch<N, T> &s, bool verbose, int active = N) {
+	// same candidate order as nash(const Game<3, 3>&)
+	StrategyBatch<N, T> candidate;
+	nash_mixed_batch(g, s);
+	nash_mixed22_batch<1, 2,  1, 2>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<1, 2,  0, 2>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<1, 2,  0, 1>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<0, 2,  1, 2>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<0, 2,  0, 2>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<0, 2,  0, 1>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<0, 1,  1, 2>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<0, 1,  0, 2>(g, candidate); s.findBestMe(candidate);
+	nash_mixed22_batch<0, 1,  0, 1>(g, candidate); s.findBestMe(candidate);
+	nash_pure_batch(g, candidate);
+	s.findBestMe(candidate);
+
+	if(verbose) {
+		for(int l = 0; l < active; ++ l) {
+			if(s.valid[l] == 0) {
+				std::array<T, 9> valuesMe;
+				std::array<T, 9> valuesThemT;
+				g.get(l, valuesMe, valuesThemT);
+				BasicGame<T, 3, 3> game(&valuesMe, &valuesThemT);
+				for(int i = 0; i < 3; ++ i) {
+					game.coordsMe[i] = i;
+					game.coordsThem[i] = i;
+				}
+				std::cerr << "No nash equilibrium found!" << std::endl;
+				debugGame(game);
+			}
+		}
+	}
+}
+
+template <typename T>
+bool sameBits(const BasicStrategy<T> &a, const BasicStrategy<T> &b) {
+	return (
+		a.valid == b.valid &&
+		std::memcmp(&a.probMe[0], &b.probMe[0], sizeof(a.probMe)) == 0 &&
+		std::memcmp(&a.probThem[0], &b.probThem[0], sizeof(a.probThem)) == 0 &&
+		std::memcmp(&a.expectedValue.me, &b.expectedValue.me, sizeof(T)) == 0 &&
+		std::memcmp(&a.expectedValue.them, &b.expectedValue.them, sizeof(T)) == 0
+	);
+}
+
+// Solves the zero-sum game where `me` gets g[m * 3 + t] and `them` gets
+// -g[m * 3 + t], as a linear program with a 3x3 simplex tableau. The
+// primal gives the strategy for `them` and the dual the strategy for `me`.
+template <typename T>
+BasicStrategy<T> minimax(const std::array<T, 9> &g) {
+	// shift all payoffs to be positive, so the game value is positive and
+	// the LP for `them` is: maximise sum(w) s.t. sum_t A[m][t] * w[t] <= 1,
+	// w >= 0 (`them` holds `me` to 1 / sum(w) with strategy w / sum(w))
+	T lowest = g[0];
+	for(int k = 1; k < 9; ++ k) {
+		lowest = std::min(lowest, g[k]);
+	}
+	const T shift = 1 - lowest;
+
+	// rows: one per action m of `me`; columns: w[0..2], slack[0..2], rhs
+	T tableau[3][7];
+	T objective[7];
+	int basis[3];
+	for(int m = 0; m < 3; ++ m) {
+		for(int t = 0; t < 3; ++ t) {
+			tableau[m][t] = g[m * 3 + t] + shift;
+		}
+		for(int k = 0; k < 3; ++ k) {
+			tableau[m][3 + k] = (k == m) ? 1 : 0;
+		}
+		tableau[m][6] = 1;
+		basis[m] = 3 + m;
+	}
+	for(int k = 0; k < 7; ++ k) {
+		objective[k] = (k < 3) ? -1 : 0;
+	}
+
+	// Bland's rule: never cycles, and a 3x3 game needs only a few pivots
+	for(int iteration = 0; iteration < 20; ++ iteration) {
+		int enter = -1;
+		for(int k = 0; k < 6; ++ k) {
+			if(objective[k] < -ScalarLimits<T>::pivot) {
+				enter = k;
+				break;
+			}
+		}
+		if(enter == -1) {
+			break;
+		}
+		int leave = -1;
+		T bestRatio = 0;
+		for(int r = 0; r < 3; ++ r) {
+			if(tableau[r][enter] > ScalarLimits<T>::pivot) {
+				const T ratio = tableau[r][6] / tableau[r][enter];
+				if(
+					leave == -1 || ratio < bestRatio ||
+					(ratio == bestRatio && basis[r] < basis[leave])
+				) {
+					leave = r;
+					bestRatio = ratio;
+				}
+			}
+		}
+		if(leave == -1) {
+			return BasicStrategy<T>(); // unbounded; impossible with positive payoffs
+		}
+		const T pivot = tableau[leave][enter];
+		for(int k = 0; k < 7; ++ k) {
+			tableau[leave][k] /= pivot;
+		}
+		for(int r = 0; r < 3; ++ r) {
+			if(r != leave) {
+				const T f = tableau[r][enter];
+				for(int k = 0; k < 7; ++ k) {
+					tableau[r][k] -= f * tableau[leave][k];
+				}
+			}
+		}
+		const T f = objective[enter];
+		for(int k = 0; k < 7; ++ k) {
+			objective[k] -= f * tableau[leave][k];
+		}
+		basis[leave] = enter;
+	}
+
+	BasicStrategy<T> s;
+	const T total = objective[6]; // = sum(w) = 1 / shifted value
+	if(!(total > 0)) {
+		return s;
+	}
+	for(int r = 0; r < 3; ++ r) {
+		if(basis[r] < 3) {
+			s.probThem[basis[r]] = tableau[r][6] / total;
+		}
+	}
+	for(int m = 0; m < 3; ++ m) {
+		s.probMe[m] = objective[3 + m] / total;
+	}
+	const T v = 1 / total - shift;
+	s.expectedValue = BasicValue<T>(v, -v);
+	s.valid = true;
+	return s;
+}
+
 struct PlayerState {
 	int balls;
 	int ducks;
@@ -377,6 +1053,18 @@ struct PlayerState {
 		return PlayerState(balls, std::max(ducks - 1, 0));
 	}
 
+	bool canReload(int maxBalls) const {
+		return balls < maxBalls;
+	}
+
+	bool canThrow(void) const {
+		return balls > 0;
+	}
+
+	bool canDuck(void) const {
+		return ducks > 0;
+	}
+
 	std::array<double,3> flail(int maxBalls) const {
 		// opponent has obvious win;
 		// try stuff at random and hope the opponent is bad
@@ -405,6 +1093,67 @@ struct PlayerState {
 	}
 };
 
+enum Action {
+	RELOAD = 0,
+	THROW = 1,
+	DUCK = 2,
+	NOTHING = 3
+};
+
+Action validAction(int action, const PlayerState &p, int maxBalls) {
+	switch(action) {
+	case RELOAD: return p.canReload(maxBalls) ? RELOAD : NOTHING;
+	case THROW: return p.canThrow() ? THROW : NOTHING;
+	case DUCK: return p.canDuck() ? DUCK : NOTHING;
+	default: return NOTHING;
+	}
+}
+
+PlayerState applyAction(const PlayerState &p, Action action, int maxBalls) {
+	switch(action) {
+	case RELOAD: return p.doReload(maxBalls);
+	case THROW: return p.doThrow();
+	case DUCK: return p.doDuck();
+	default: return p;
+	}
+}
+
+// Plays one turn (same rules as manager.sh); invalid actions do nothing.
+// Returns 1 if A hit B, -1 if B hit A, or 0 if the game continues
+int resolveTurn(PlayerState &a, PlayerState &b, int actionA, int actionB, int maxBalls) {
+	Action actA = validAction(actionA, a, maxBalls);
+	Action actB = validAction(actionB, b, maxBalls);
+	if(actA == THROW && actB != THROW && actB != DUCK) {
+		return 1;
+	}
+	if(actB == THROW && actA != THROW && actA != DUCK) {
+		return -1;
+	}
+	a = applyAction(a, actA, maxBalls);
+	b = applyAction(b, actB, maxBalls);
+	return 0;
+}
+
+enum Obvious {
+	NOT_OBVIOUS,
+	OBVIOUS_WIN, // me has more balls than them has balls + ducks
+	OBVIOUS_LOSS, // and the other way around
+	OBVIOUS_RELOAD // neither has any balls
+};
+
+// States with a rule-decided answer, which never need the nash solver
+Obvious obviousCase(const PlayerState &me, const PlayerState &them) {
+	if(me.balls > them.balls + them.ducks) {
+		return OBVIOUS_WIN;
+	} else if(them.balls > me.balls + me.ducks) {
+		return OBVIOUS_LOSS;
+	} else if(me.balls == 0 && them.balls == 0) {
+		return OBVIOUS_RELOAD;
+	} else {
+		return NOT_OBVIOUS;
+	}
+}
+
 class GameStore {
 protected:
 	const int balls;
@@ -417,6 +1166,11 @@ public:
 		return "nashdata_" + std::to_string(turn) + ".dat";
 	}
 
+	static char toDat(NumT v) {
+		int iv = int(v * 256.0);
+		return char(std::max(std::min(iv, 255), 0));
+	}
+
 	GameStore(int maxBalls, int maxDucks)
 		: balls(maxBalls)
 		, ducks(maxDucks)
@@ -424,6 +1178,25 @@ public:
 		, gameStates(playerStates * playerStates)
 	{}
 
+	int maxBalls(void) const {
+		return balls;
+	}
+
+	int maxDucks(void) const {
+		return ducks;
+	}
+
+	std::size_t fileSize(void) const {
+		return 2 + gameStates * 2;
+	}
+
+	bool contains(const PlayerState &p) const {
+		return (
+			p.balls >= 0 && p.balls <= balls &&
+			p.ducks >= 0 && p.ducks <= ducks
+		);
+	}
+
 	std::size_t playerIndex(const PlayerState &p) const {
 		return p.balls * (ducks + 1) + p.ducks;
 	}
@@ -436,6 +1209,12 @@ public:
 		return 2 + gameIndex(me, them) * 2;
 	}
 
+	// The index in slab order (see SlabTableHeader)
+	std::size_t slabIndex(const PlayerState &me, const PlayerState &them) const {
+		const std::size_t side = balls + 1;
+		return ((std::size_t(me.ducks) * (ducks + 1) + them.ducks) * side + me.balls) * side + them.balls;
+	}
+
 	PlayerState stateFromPlayerIndex(std::size_t i) const {
 		return PlayerState(i / (ducks + 1), i % (ducks + 1));
 	}
@@ -452,318 +1231,4483 @@ public:
 	}
 };
 
-class Generator : public GameStore {
-	static char toDat(NumT v) {
-		int iv = int(v * 256.0);
-		return char(std::max(std::min(iv, 255), 0));
-	}
+// Multi-turn policy archive: a header, then encoded blocks, then an index of
+// turn ranges and tables. Each table is split into blocks of ARCHIVE_BLOCK
+// states, stored either as runs of identical entries, or as the entries which
+// differ from the same block of the table's keyframe (a table of runs only)
+static const char ARCHIVE_MAGIC[8] = {'P', 'I', 'T', 'N', 'A', 'R', 'C', '1'};
+static const std::size_t ARCHIVE_BLOCK = 256;
+static const unsigned char ARCHIVE_RUNS = 0;
+static const unsigned char ARCHIVE_PATCH = 1;
 
-	std::vector<Value> next;
+struct ArchiveHeader {
+	char magic[8];
+	std::uint32_t balls;
+	std::uint32_t ducks;
+	std::uint32_t turns; // every turn below this is in a range
+	std::uint32_t ranges;
+	std::uint32_t tables;
+	std::uint32_t keyframes;
+	// ArchiveRange[ranges], then for each table its keyframe's table number
+	// and the file offset of each block (all as uint64)
+	std::uint64_t indexOffset;
+};
 
-public:
-	Generator(int maxBalls, int maxDucks)
-		: GameStore(maxBalls, maxDucks)
-		, next()
-	{}
+struct ArchiveRange {
+	std::uint32_t first;
+	std::uint32_t last; // inclusive
+	std::uint64_t table;
+};
 
-	const Value &nextGame(const PlayerState &me, const PlayerState &them) const {
-		return next[gameIndex(me, them)];
-	}
+// Sparse table: the same header fields as an archive, then a bit per state
+// (set if stored), the number of stored states before each SPARSE_SUPERBLOCK
+// states (uint32), and the stored entries. Rule-decided states are left out
+static const char SPARSE_MAGIC[8] = {'P', 'I', 'T', 'N', 'S', 'P', 'R', '1'};
+static const std::size_t SPARSE_SUPERBLOCK = 256;
 
-	void make_probabilities(
-		std::array<NumT, 9> &g,
-		const PlayerState &me,
-		const PlayerState &them
-	) const {
-		const int RELOAD = 0;
-		const int THROW = 1;
-		const int DUCK = 2;
+struct SparseHeader {
+	char magic[8];
+	std::uint32_t balls;
+	std::uint32_t ducks;
+	std::uint64_t stored;
+};
 
-		g[RELOAD * 3 + RELOAD] =
-			nextGame(me.doReload(balls), them.doReload(balls)).me;
+// On-demand solving cache: a file per slab (the states where me has meDucks
+// and them has themDucks) holding its converged values as doubles, then its
+// entries. A slab only depends on slabs with fewer ducks, never on the duck
+// limit of the table, so it can be shared by any table with the same balls
+static const char SLAB_MAGIC[8] = {'P', 'I', 'T', 'N', 'S', 'L', 'B', '1'};
 
-		g[RELOAD * 3 + THROW] =
-			(them.balls > 0) ? -1
-			: nextGame(me.doReload(balls), them.doThrow()).me;
+struct SlabHeader {
+	char magic[8];
+	std::uint32_t balls;
+	std::uint32_t meDucks;
+	std::uint32_t themDucks;
+	float tolerance; // the largest change from one more pass
+};
 
-		g[RELOAD * 3 + DUCK] =
-			nextGame(me.doReload(balls), them.doDuck()).me;
+// Slab-ordered table, for limits too large for a dense table's header or
+// for generating in memory: the entries of each slab (see SlabHeader) in
+// turn, by meDucks then themDucks, each ordered by meBalls then themBalls
+static const char SLAB_TABLE_MAGIC[8] = {'P', 'I', 'T', 'N', 'S', 'T', 'B', '1'};
 
-		g[THROW * 3 + RELOAD] =
-			(me.balls > 0) ? 1
-			: nextGame(me.doThrow(), them.doReload(balls)).me;
+struct SlabTableHeader {
+	char magic[8];
+	std::uint32_t balls;
+	std::uint32_t ducks;
+};
 
-		g[THROW * 3 + THROW] =
-			((me.balls > 0) == (them.balls > 0))
-			? nextGame(me.doThrow(), them.doThrow()).me
-			: (me.balls > 0) ? 1 : -1;
+// Master table: a dense table (as nashdata_<turn>.dat) for every ball limit
+// from 1 to balls, all with the same duck limit. Duck counts never go up, so
+// each also answers any smaller duck limit. The header is followed by the
+// file offset of each table (uint64, by ball limit - 1)
+static const char MASTER_MAGIC[8] = {'P', 'I', 'T', 'N', 'M', 'S', 'T', '1'};
 
-		g[THROW * 3 + DUCK] =
-			(me.balls > 0 && them.ducks == 0) ? 1
-			: nextGame(me.doThrow(), them.doDuck()).me;
+struct MasterHeader {
+	char magic[8];
+	std::uint32_t balls;
+	std::uint32_t ducks;
+};
 
-		g[DUCK * 3 + RELOAD] =
-			nextGame(me.doDuck(), them.doReload(balls)).me;
+// Generation checkpoint: the values of the last turn generated, its table,
+// and in worklist mode the worklist state; everything needed to carry on
+// from the next turn with the same results
+static const char CHECKPOINT_MAGIC[8] = {'P', 'I', 'T', 'N', 'C', 'K', 'P', '1'};
 
-		g[DUCK * 3 + THROW] =
-			(them.balls > 0 && me.ducks == 0) ? -1
-			: nextGame(me.doDuck(), them.doThrow()).me;
+struct CheckpointHeader {
+	char magic[8];
+	std::uint32_t balls;
+	std::uint32_t ducks;
+	std::uint32_t valueSize; // bytes per value (float or double)
+	std::uint32_t worklist;
+	std::uint32_t supportCache;
+	std::uint64_t turn; // the values are for this turn
+	double sweeps;
+};
 
-		g[DUCK * 3 + DUCK] =
-			nextGame(me.doDuck(), them.doDuck()).me;
-	}
+// Writes checkpoints on a background thread, so that the next sweep can run
+// meanwhile. Each is written to a temporary file, synced, then renamed into
+// place, so the checkpoint file is always a complete one
+class CheckpointWriter {
+	const std::string filename;
+	std::vector<char> image;
+	std::thread thread;
+	std::atomic<bool> failed;
 
-	Game<3, 3> make_game(const PlayerState &me, const PlayerState &them) const {
-		static std::array<NumT, 9> globalValuesMe;
-		static std::array<NumT, 9> globalValuesThemT;
-		#pragma omp threadprivate(globalValuesMe)
-		#pragma omp threadprivate(globalValuesThemT)
+	CheckpointWriter(const CheckpointWriter&) = delete;
+	CheckpointWriter &operator=(const CheckpointWriter&) = delete;
 
-		make_probabilities(globalValuesMe, me, them);
-		make_probabilities(globalValuesThemT, them, me);
-		Game<3, 3> g(&globalValuesMe, &globalValuesThemT);
-		for(int i = 0; i < 3; ++ i) {
-			g.coordsMe[i] = i;
-			g.coordsThem[i] = i;
+	void run(void) {
+		const std::string temp = filename + "." + std::to_string(getpid()) + ".tmp";
+		FILE *f = std::fopen(temp.c_str(), "wb");
+		bool ok = (f != NULL);
+		if(f) {
+			ok = std::fwrite(&image[0], 1, image.size(), f) == image.size();
+			ok = (std::fflush(f) == 0) && ok;
+			ok = (fsync(fileno(f)) == 0) && ok;
+			ok = (std::fclose(f) == 0) && ok;
+		}
+		if(!ok || std::rename(temp.c_str(), filename.c_str()) != 0) {
+			std::remove(temp.c_str());
+			failed = true;
 		}
-		return g;
 	}
 
-	Strategy solve(const PlayerState &me, const PlayerState &them, bool verbose) const {
-		if(me.balls > them.balls + them.ducks) { // obvious answer
-			Strategy s;
-			s.probMe[1] = 1;
-			s.probThem = them.flail(balls);
-			s.expectedValue = Value(1, -1);
-			return s;
-		} else if(them.balls > me.balls + me.ducks) { // uh-oh
-			Strategy s;
+public:
+	static std::string defaultFilename(void) {
+		return "nashcheckpoint.dat";
+	}
+
+	explicit CheckpointWriter(const std::string &filename = defaultFilename())
+		: filename(filename)
+		, image()
+		, thread()
+		, failed(false)
+	{}
+
+	~CheckpointWriter(void) {
+		wait();
+	}
+
+	// Takes the checkpoint (see BasicGenerator::checkpoint); waits for the
+	// last one to finish first
+	void write(std::vector<char> &&checkpoint) {
+		wait();
+		image = std::move(checkpoint);
+		thread = std::thread(&CheckpointWriter::run, this);
+	}
+
+	// Returns false if any checkpoint failed to write
+	bool wait(void) {
+		if(thread.joinable()) {
+			thread.join();
+		}
+		return !failed;
+	}
+
+	// Once the run is complete, so that it isn't resumed
+	void remove(void) {
+		wait();
+		std::remove(filename.c_str());
+	}
+};
+
+class ArchiveWriter {
+	// a new keyframe is started once patching a table against the current
+	// keyframe would take more than 1/KEYFRAME_RATIO of the keyframe's size
+	static const std::size_t KEYFRAME_RATIO = 4;
+
+	const GameStore store;
+	const std::string filename;
+	std::ofstream out;
+	std::uint64_t offset;
+	std::vector<ArchiveRange> ranges;
+	std::vector<std::vector<std::uint64_t>> tables; // keyframe, then blocks
+	std::size_t keyframes;
+	std::vector<char> previous;
+	std::vector<char> keyframe;
+	std::uint64_t keyframeTable;
+	std::size_t keyframeSize;
+
+	std::size_t blockCount(void) const {
+		return (store.fileSize() / 2 - 1 + ARCHIVE_BLOCK - 1) / ARCHIVE_BLOCK;
+	}
+
+	static void encodeRuns(const char *block, std::size_t states, std::string &out) {
+		out += char(ARCHIVE_RUNS);
+		for(std::size_t i = 0; i < states;) {
+			std::size_t n = 1;
+			while(
+				i + n < states && n < 255 &&
+				block[(i+n)*2] == block[i*2] && block[(i+n)*2+1] == block[i*2+1]
+			) {
+				++ n;
+			}
+			out += char(n);
+			out += block[i*2];
+			out += block[i*2+1];
+			i += n;
+		}
+	}
+
+	static void encodePatch(
+		const char *block,
+		const char *key,
+		std::size_t states,
+		std::string &out
+	) {
+		out += char(ARCHIVE_PATCH);
+		out += char(0);
+		out += char(0);
+		std::size_t count = 0;
+		for(std::size_t i = 0; i < states; ++ i) {
+			if(block[i*2] != key[i*2] || block[i*2+1] != key[i*2+1]) {
+				out += char(i);
+				out += block[i*2];
+				out += block[i*2+1];
+				++ count;
+			}
+		}
+		out[out.size() - count * 3 - 2] = char(count & 0xFF);
+		out[out.size() - count * 3 - 1] = char(count >> 8);
+	}
+
+	// Encodes every block of data, patched against the keyframe if patch is
+	// set; returns the total size
+	std::size_t encode(
+		const char *data,
+		bool patch,
+		std::string &encoded,
+		std::vector<std::uint64_t> &blocks
+	) const {
+		encoded.clear();
+		std::string runs;
+		std::string patched;
+		const std::size_t states = store.fileSize() / 2 - 1;
+		for(std::size_t b = 0; b < blockCount(); ++ b) {
+			const std::size_t begin = b * ARCHIVE_BLOCK;
+			const std::size_t n = std::min(ARCHIVE_BLOCK, states - begin);
+			runs.clear();
+			encodeRuns(data + 2 + begin * 2, n, runs);
+			blocks[b + 1] = encoded.size();
+			if(patch) {
+				patched.clear();
+				encodePatch(data + 2 + begin * 2, &keyframe[2 + begin * 2], n, patched);
+				if(patched.size() < runs.size()) {
+					encoded += patched;
+					continue;
+				}
+			}
+			encoded += runs;
+		}
+		return encoded.size();
+	}
+
+	template <typename T>
+	void put(const T &v) {
+		out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+		offset += sizeof(v);
+	}
+
+public:
+	static std::string defaultFilename(void) {
+		return "nashdata.arc";
+	}
+
+	ArchiveWriter(const GameStore &store, const std::string &filename = defaultFilename())
+		: store(store)
+		, filename(filename)
+		, out((filename + ".tmp").c_str(), std::ios_base::binary)
+		, offset(0)
+		, ranges()
+		, tables()
+		, keyframes(0)
+		, previous()
+		, keyframe()
+		, keyframeTable(0)
+		, keyframeSize(0)
+	{
+		ArchiveHeader header = ArchiveHeader();
+		put(header); // filled in by finish()
+	}
+
+	// Adds the table for a turn; turns must be added in decreasing order
+	void add(int turn, const DataVector &data) {
+		if(
+			!ranges.empty() && ranges.back().first == std::uint32_t(turn + 1) &&
+			std::equal(data.begin(), data.end(), previous.begin())
+		) {
+			ranges.back().first = turn;
+			return;
+		}
+
+		std::vector<std::uint64_t> blocks(blockCount() + 1);
+		std::string encoded;
+		std::size_t size = 0;
+		if(!keyframe.empty()) {
+			size = encode(&data[0], true, encoded, blocks);
+		}
+		if(keyframe.empty() || size * KEYFRAME_RATIO > keyframeSize) {
+			keyframe.assign(data.begin(), data.end());
+			keyframeTable = tables.size();
+			keyframeSize = encode(&data[0], false, encoded, blocks);
+			++ keyframes;
+		}
+		blocks[0] = keyframeTable;
+		for(std::size_t b = 1; b < blocks.size(); ++ b) {
+			blocks[b] += offset;
+		}
+		out.write(encoded.data(), encoded.size());
+		offset += encoded.size();
+
+		ArchiveRange range;
+		range.first = turn;
+		range.last = turn;
+		range.table = tables.size();
+		ranges.push_back(range);
+		tables.push_back(std::move(blocks));
+		previous.assign(data.begin(), data.end());
+	}
+
+	// Writes the index; turns below the last one added use its table (as
+	// turns without a file fall back to nashdata_0.dat). Returns the size
+	std::uint64_t finish(void) {
+		if(ranges.empty()) {
+			out.close();
+			std::remove((filename + ".tmp").c_str());
+			return 0;
+		}
+		ranges.back().first = 0;
+		std::reverse(ranges.begin(), ranges.end());
+		while(offset % 8 != 0) {
+			put(char(0));
+		}
+
+		ArchiveHeader header = ArchiveHeader();
+		std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+		header.balls = store.maxBalls();
+		header.ducks = store.maxDucks();
+		header.turns = ranges.back().last + 1;
+		header.ranges = ranges.size();
+		header.tables = tables.size();
+		header.keyframes = keyframes;
+		header.indexOffset = offset;
+		for(const ArchiveRange &range : ranges) {
+			put(range);
+		}
+		for(const std::vector<std::uint64_t> &blocks : tables) {
+			out.write(reinterpret_cast<const char*>(&blocks[0]), blocks.size() * 8);
+			offset += blocks.size() * 8;
+		}
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.close();
+		std::rename((filename + ".tmp").c_str(), filename.c_str());
+		return offset;
+	}
+
+	std::size_t tableCount(void) const {
+		return tables.size();
+	}
+
+	std::size_t keyframeCount(void) const {
+		return keyframes;
+	}
+};
+
+struct SweepStats {
+	NumT msd;
+	NumT maxDiff;
+	std::size_t solved;
+	std::size_t zeroSumSolved;
+	std::size_t zeroSumFallback;
+	std::size_t supportHits;
+	std::size_t supportMisses;
+
+	SweepStats(void)
+		: msd(0)
+		, maxDiff(0)
+		, solved(0)
+		, zeroSumSolved(0)
+		, zeroSumFallback(0)
+		, supportHits(0)
+		, supportMisses(0)
+	{}
+
+	void addDiff(NumT diff) {
+		msd += diff * diff;
+		maxDiff = std::max(maxDiff, std::abs(diff));
+	}
+
+	void add(const SweepStats &b) {
+		msd += b.msd;
+		maxDiff = std::max(maxDiff, b.maxDiff);
+		solved += b.solved;
+		zeroSumSolved += b.zeroSumSolved;
+		zeroSumFallback += b.zeroSumFallback;
+		supportHits += b.supportHits;
+		supportMisses += b.supportMisses;
+	}
+};
+
+enum Precision {
+	PRECISION_DOUBLE,
+	PRECISION_FLOAT,
+	PRECISION_MIXED // float until nearly converged, then double
+};
+
+// What generate() writes: nothing (the caller takes table()), only the
+// converged nashdata_0.dat, or every turn as well
+enum SaveMode {
+	SAVE_NOTHING,
+	SAVE_FINAL,
+	SAVE_ALL
+};
+
+struct GenerateOptions {
+	// only solve states where playerIndex(me) <= playerIndex(them), and fill
+	// in (them, me) from the transposed strategy
+	bool symmetric;
+	// number of mirrored states to re-solve each turn as a check
+	int verifySamples;
+	// time sweeps at increasing thread counts instead of generating
+	bool scaling;
+	// solve states in batches with nash_batch
+	bool batched;
+	// solve zero-sum states with the minimax kernel
+	bool zeroSum;
+	// try each state's equilibrium support from the last sweep first
+	bool supportCache;
+	// solve for the fixed point in place instead of turn by turn
+	bool stationary;
+	// stop once a sweep (or stationary pass) changes no value by more than this
+	NumT tolerance;
+	// only re-solve states with a successor which moved in the last sweep
+	bool worklist;
+	// how far a value can drift before its predecessors are re-solved
+	NumT worklistTolerance;
+	// save every turn to one archive instead of a file per turn
+	bool archive;
+	// save tables without their rule-decided states
+	bool sparse;
+	// scalar type for values and the solver
+	Precision precision;
+	// also generate in double precision, and compare the final tables
+	bool precisionReport;
+	// seconds a single-turn call can spend solving slabs which are not in
+	// the cache (see solveReachable)
+	double budget;
+	// generate a master table for every ball limit (see MasterHeader)
+	bool master;
+	// generate a slab-ordered table a few slabs at a time
+	bool outOfCore;
+	// turns between checkpoints (0 for none), and whether to start from the
+	// last checkpoint (see CheckpointWriter)
+	int checkpoint;
+	bool resume;
+
+	GenerateOptions(void)
+		: symmetric(false)
+		, verifySamples(1000)
+		, scaling(false)
+		, batched(false)
+		, zeroSum(false)
+		, supportCache(false)
+		, stationary(false)
+		, tolerance(0.0001f)
+		, worklist(false)
+		, worklistTolerance(1e-7)
+		, archive(false)
+		, sparse(false)
+		, precision(PRECISION_DOUBLE)
+		, precisionReport(false)
+		, budget(1)
+		, master(false)
+		, outOfCore(false)
+		, checkpoint(0)
+		, resume(false)
+	{}
+
+	bool parse(const std::string &arg) {
+		if(arg == "--symmetric") {
+			symmetric = true;
+		} else if(arg == "--scaling") {
+			scaling = true;
+		} else if(arg == "--batched") {
+			batched = true;
+		} else if(arg == "--zero-sum") {
+			zeroSum = true;
+		} else if(arg == "--support-cache") {
+			supportCache = true;
+		} else if(arg == "--stationary") {
+			stationary = true;
+		} else if(arg == "--precision=double") {
+			precision = PRECISION_DOUBLE;
+		} else if(arg == "--precision=float") {
+			precision = PRECISION_FLOAT;
+		} else if(arg == "--precision=mixed") {
+			precision = PRECISION_MIXED;
+		} else if(arg == "--precision-report") {
+			precisionReport = true;
+		} else if(arg == "--sparse") {
+			sparse = true;
+		} else if(arg == "--archive") {
+			archive = true;
+		} else if(arg == "--resume") {
+			resume = true;
+		} else if(arg.compare(0, 13, "--checkpoint=") == 0) {
+			checkpoint = std::atoi(arg.c_str() + 13);
+		} else if(arg == "--out-of-core") {
+			outOfCore = true;
+		} else if(arg == "--master") {
+			master = true;
+		} else if(arg == "--worklist") {
+			worklist = true;
+		} else if(arg.compare(0, 21, "--worklist-tolerance=") == 0) {
+			worklistTolerance = std::atof(arg.c_str() + 21);
+		} else if(arg.compare(0, 12, "--tolerance=") == 0) {
+			tolerance = std::atof(arg.c_str() + 12);
+		} else if(arg.compare(0, 9, "--budget=") == 0) {
+			budget = std::atof(arg.c_str() + 9);
+		} else if(arg.compare(0, 17, "--verify-samples=") == 0) {
+			verifySamples = std::atoi(arg.c_str() + 17);
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	// The options for a generation started on the side (a master table's
+	// ball limits, or a reference run), which must not share the run's
+	// checkpoint file
+	GenerateOptions withoutCheckpoint(void) const {
+		GenerateOptions copy = *this;
+		copy.checkpoint = 0;
+		copy.resume = false;
+		return copy;
+	}
+};
+
+#ifdef PITN_TELEMETRY
+// Appends JSON lines to nashtelemetry.jsonl: one when generation starts,
+// then one per sweep (or stationary solve) with its timings, convergence,
+// and the solver counters collected since the last line. Times are wall
+// clock, except the solver timers, which add up every thread's time
+class TelemetryLog {
+	std::ofstream out;
+	std::size_t states;
+
+	static double seconds(
+		std::chrono::steady_clock::time_point a,
+		std::chrono::steady_clock::time_point b
+	) {
+		return std::chrono::duration<double>(b - a).count();
+	}
+
+public:
+	TelemetryLog(int balls, int ducks, std::size_t states, const GenerateOptions &options)
+		: out("nashtelemetry.jsonl", std::ios_base::app)
+		, states(states)
+	{
+		int threads = 1;
+#ifdef _OPENMP
+		threads = omp_get_max_threads();
+#endif
+		Telemetry::global().collect(); // (drops anything counted before)
+		out
+			<< "{\"phase\": \"start\", \"balls\": " << balls << ", \"ducks\": " << ducks
+			<< ", \"states\": " << states << ", \"threads\": " << threads
+			<< ", \"batched\": " << options.batched << ", \"zero_sum\": " << options.zeroSum
+			<< ", \"support_cache\": " << options.supportCache
+			<< ", \"stationary\": " << options.stationary << ", \"worklist\": " << options.worklist
+			<< "}" << std::endl;
+	}
+
+	// begin..solved is the solve, written..end the file write
+	void write(
+		const char *phase,
+		std::size_t turn,
+		const SweepStats &stats,
+		std::chrono::steady_clock::time_point begin,
+		std::chrono::steady_clock::time_point solved,
+		std::chrono::steady_clock::time_point written,
+		std::chrono::steady_clock::time_point end
+	) {
+		const TelemetrySlot total = Telemetry::global().collect();
+		out
+			<< "{\"phase\": \"" << phase << "\", \"turn\": " << turn
+			<< ", \"wall_s\": " << seconds(begin, end)
+			<< ", \"solve_s\": " << seconds(begin, solved)
+			<< ", \"write_s\": " << seconds(written, end)
+			<< ", \"max_diff\": " << stats.maxDiff
+			<< ", \"rmsd\": " << std::sqrt(stats.msd / states)
+			<< ", \"solved\": " << stats.solved
+			<< ", \"zero_sum\": " << stats.zeroSumSolved
+			<< ", \"zero_sum_fallback\": " << stats.zeroSumFallback
+			<< ", \"support_hits\": " << stats.supportHits
+			<< ", \"support_misses\": " << stats.supportMisses;
+		for(int i = 0; i < TELEMETRY_TIMERS; ++ i) {
+			out << ", \"" << TELEMETRY_TIMER_NAMES[i] << "\": " << (total.nanos[i] * 1e-9);
+		}
+		for(int i = 0; i < TELEMETRY_COUNTERS; ++ i) {
+			out << ", \"" << TELEMETRY_COUNTER_NAMES[i] << "\": " << total.counts[i];
+		}
+		out << "}" << std::endl;
+	}
+};
+#endif
+
+template <typename T>
+class BasicGenerator : public GameStore {
+	typedef BasicValue<T> Value;
+	typedef BasicValueVector<T> ValueVector;
+	typedef BasicStrategy<T> Strategy;
+	template <int dimMe, int dimThem>
+	using Game = BasicGame<T, dimMe, dimThem>;
+
+	// states per scheduling chunk; small enough to balance the uneven cost
+	// of solve() across threads, large enough to keep successors in cache
+	static const std::size_t TILE = 512;
+	// games per nash_batch call (fills an AVX-512 register)
+	static const int BATCH = 8;
+	// passes per slab when solving on demand, which converge long before this
+	static const int LAZY_MAX_PASSES = 1000;
+	// turn tables waiting to be saved before add() waits for the writer
+	static const std::size_t WRITE_QUEUE = 2;
+
+	ValueVector next;
+	// worklist mode (empty otherwise): states with a successor which moved in
+	// the last sweep, and the values their predecessors were last re-solved with
+	std::vector<char> dirty;
+	ValueVector propagated;
+	// the table for the last turn generated
+	DataVector data;
+	bool resumed;
+	// on-demand solving only: which slabs of next hold converged values
+	std::vector<char> finished;
+	// support cache mode (empty otherwise): the nash_candidate which won for
+	// each state the last time it was solved. Each state is solved by one
+	// thread per sweep, so the const sweeps update it in place
+	mutable std::vector<std::uint8_t> supports;
+	// out-of-core generation only: next, data (and the current passed in)
+	// hold just three rows of slabs (see valueIndex)
+	bool windowed;
+
+	// the player index after each action (reload, throw, duck) from each
+	// player index, so that make_probabilities() only has to add them up
+	std::vector<std::uint32_t> moves;
+	// the reverse of moves: the player indices which lead to player index i
+	// are predecessors[predecessorStart[i]] up to predecessorStart[i + 1]
+	std::vector<std::uint32_t> predecessorStart;
+	std::vector<std::uint32_t> predecessors;
+
+	// Where a state is kept in next and data: normally its game index, but
+	// when windowed, each slab's total duck count picks one of three rows
+	// (solving a slab only reads slabs with one or two fewer ducks), and the
+	// slab is at meDucks within that row
+	std::size_t valueIndex(std::size_t meIndex, std::size_t themIndex) const {
+		if(!windowed) {
+			return meIndex * playerStates + themIndex;
+		}
+		const std::size_t side = balls + 1;
+		const PlayerState me = stateFromPlayerIndex(meIndex);
+		const PlayerState them = stateFromPlayerIndex(themIndex);
+		const std::size_t slab = ((me.ducks + them.ducks) % 3) * (ducks + 1) + me.ducks;
+		return (slab * side + me.balls) * side + them.balls;
+	}
+
+	std::size_t valueIndex(const PlayerState &me, const PlayerState &them) const {
+		return valueIndex(playerIndex(me), playerIndex(them));
+	}
+
+public:
+	BasicGenerator(int maxBalls, int maxDucks)
+		: GameStore(maxBalls, maxDucks)
+		, next()
+		, dirty()
+		, propagated()
+		, data()
+		, resumed(false)
+		, finished()
+		, supports()
+		, windowed(false)
+		, moves(playerStates * 3)
+		, predecessorStart(playerStates + 1)
+		, predecessors()
+	{
+		for(std::size_t i = 0; i < playerStates; ++ i) {
+			const PlayerState p = stateFromPlayerIndex(i);
+			moves[i * 3] = playerIndex(p.doReload(balls));
+			moves[i * 3 + 1] = playerIndex(p.doThrow());
+			moves[i * 3 + 2] = playerIndex(p.doDuck());
+		}
+		std::vector<std::vector<std::uint32_t>> from(playerStates);
+		for(std::size_t i = 0; i < playerStates; ++ i) {
+			for(int a = 0; a < 3; ++ a) {
+				std::vector<std::uint32_t> &f = from[moves[i * 3 + a]];
+				if(std::find(f.begin(), f.end(), i) == f.end()) {
+					f.push_back(i);
+				}
+			}
+		}
+		for(std::size_t i = 0; i < playerStates; ++ i) {
+			predecessorStart[i] = predecessors.size();
+			predecessors.insert(predecessors.end(), from[i].begin(), from[i].end());
+		}
+		predecessorStart[playerStates] = predecessors.size();
+	}
+
+	const Value &nextGame(const PlayerState &me, const PlayerState &them) const {
+		return next[valueIndex(me, them)];
+	}
+
+	void make_probabilities(
+		std::array<T, 9> &g,
+		const PlayerState &me,
+		const PlayerState &them
+	) const {
+		const int RELOAD = 0;
+		const int THROW = 1;
+		const int DUCK = 2;
+
+		const std::uint32_t *meNext = &moves[playerIndex(me) * 3];
+		const std::uint32_t *themNext = &moves[playerIndex(them) * 3];
+		auto nextMe = [this, meNext, themNext] (int m, int t) {
+			return next[valueIndex(meNext[m], themNext[t])].me;
+		};
+
+		g[RELOAD * 3 + RELOAD] = nextMe(RELOAD, RELOAD);
+
+		g[RELOAD * 3 + THROW] =
+			(them.balls > 0) ? -1
+			: nextMe(RELOAD, THROW);
+
+		g[RELOAD * 3 + DUCK] = nextMe(RELOAD, DUCK);
+
+		g[THROW * 3 + RELOAD] =
+			(me.balls > 0) ? 1
+			: nextMe(THROW, RELOAD);
+
+		g[THROW * 3 + THROW] =
+			((me.balls > 0) == (them.balls > 0))
+			? nextMe(THROW, THROW)
+			: (me.balls > 0) ? 1 : -1;
+
+		g[THROW * 3 + DUCK] =
+			(me.balls > 0 && them.ducks == 0) ? 1
+			: nextMe(THROW, DUCK);
+
+		g[DUCK * 3 + RELOAD] = nextMe(DUCK, RELOAD);
+
+		g[DUCK * 3 + THROW] =
+			(them.balls > 0 && me.ducks == 0) ? -1
+			: nextMe(DUCK, THROW);
+
+		g[DUCK * 3 + DUCK] = nextMe(DUCK, DUCK);
+	}
+
+	Game<3, 3> make_game(const PlayerState &me, const PlayerState &them) const {
+		// (thread_local rather than omp threadprivate, which can't take a
+		// type that depends on T)
+		static thread_local std::array<T, 9> globalValuesMe;
+		static thread_local std::array<T, 9> globalValuesThemT;
+
+		make_probabilities(globalValuesMe, me, them);
+		make_probabilities(globalValuesThemT, them, me);
+		Game<3, 3> g(&globalValuesMe, &globalValuesThemT);
+		for(int i = 0; i < 3; ++ i) {
+			g.coordsMe[i] = i;
+			g.coordsThem[i] = i;
+		}
+		return g;
+	}
+
+	// Builds only the payoff matrix for `me` and checks that the successors
+	// it reads are zero-sum (each Value has them == -me), so that the
+	// matrix for `them` is just its negated transpose
+	bool make_zero_sum(
+		std::array<T, 9> &g,
+		const PlayerState &me,
+		const PlayerState &them
+	) const {
+		make_probabilities(g, me, them);
+		const PlayerState meNext[3] = {me.doReload(balls), me.doThrow(), me.doDuck()};
+		const PlayerState themNext[3] = {them.doReload(balls), them.doThrow(), them.doDuck()};
+		for(int m = 0; m < 3; ++ m) {
+			for(int t = 0; t < 3; ++ t) {
+				// (outcomes decided by a hit are +/-1 and always zero-sum)
+				const Value &v = nextGame(meNext[m], themNext[t]);
+				if(std::abs(v.me + v.them) > ScalarLimits<T>::zeroSum) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool solveZeroSum(
+		const PlayerState &me,
+		const PlayerState &them,
+		const GenerateOptions &options,
+		Strategy &s,
+		SweepStats &stats
+	) const {
+		if(!options.zeroSum) {
+			return false;
+		}
+		std::array<T, 9> g;
+		if(!make_zero_sum(g, me, them)) {
+			++ stats.zeroSumFallback;
+			return false;
+		}
+		std::array<double, 9> precise;
+		std::copy(g.begin(), g.end(), precise.begin());
+		s = narrow(minimax(precise));
+		if(!s.valid) {
+			++ stats.zeroSumFallback;
+			return false;
+		}
+		++ stats.zeroSumSolved;
+		return true;
+	}
+
+	static std::array<T, 3> scalars(const std::array<double, 3> &p) {
+		return std::array<T, 3>{{T(p[0]), T(p[1]), T(p[2])}};
+	}
+
+	// Fills in states which have a rule-decided answer; returns false if
+	// the state needs the nash solver
+	bool solveObvious(const PlayerState &me, const PlayerState &them, Strategy &s) const {
+		switch(obviousCase(me, them)) {
+		case OBVIOUS_WIN:
+			TELEMETRY(++ telemetry().counts[COUNT_OBVIOUS_WIN];)
+			s.probMe[1] = 1;
+			s.probThem = scalars(them.flail(balls));
+			s.expectedValue = Value(1, -1);
+			return true;
+		case OBVIOUS_LOSS: // uh-oh
+			TELEMETRY(++ telemetry().counts[COUNT_OBVIOUS_LOSS];)
 			s.probThem[1] = 1;
-			s.probMe = me.flail(balls);
+			s.probMe = scalars(me.flail(balls));
 			s.expectedValue = Value(-1, 1);
-			return s;
-		} else if(me.balls == 0 && them.balls == 0) { // obvious answer
-			Strategy s;
+			return true;
+		case OBVIOUS_RELOAD:
+			TELEMETRY(++ telemetry().counts[COUNT_OBVIOUS_RELOAD];)
 			s.probMe[0] = 1;
 			s.probThem[0] = 1;
 			s.expectedValue = nextGame(me.doReload(balls), them.doReload(balls));
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Payoffs are all close to +/-1, so in single precision their
+	// differences lose most of their bits, and the errors in the equilibria
+	// add up over the sweeps; values are only stored in T, and every game is
+	// solved in double precision
+	// (in support cache mode, when given the stats to count hits in)
+	Strategy solveGame(const PlayerState &me, const PlayerState &them, bool verbose, SweepStats *cached = nullptr) const {
+		TELEMETRY(++ telemetry().counts[COUNT_NASH]; TelemetryScope scope(TIME_NASH);)
+		if(std::is_same<T, double>::value) {
+			return solveNash(make_game(me, them), me, them, verbose, cached);
+		}
+		return solvePrecisely(me, them, verbose, cached);
+	}
+
+	template <typename U>
+	BasicStrategy<U> solveNash(
+		const BasicGame<U, 3, 3> &g,
+		const PlayerState &me,
+		const PlayerState &them,
+		bool verbose,
+		SweepStats *cached
+	) const {
+		if(!cached || supports.empty()) {
+			return nash(g, verbose);
+		}
+		bool hit;
+		BasicStrategy<U> s = nash_cached(g, verbose, supports[gameIndex(me, them)], hit);
+		++ (hit ? cached->supportHits : cached->supportMisses);
+		return s;
+	}
+
+	static Strategy narrow(const BasicStrategy<double> &precise) {
+		Strategy s;
+		std::copy(precise.probMe.begin(), precise.probMe.end(), s.probMe.begin());
+		std::copy(precise.probThem.begin(), precise.probThem.end(), s.probThem.begin());
+		s.expectedValue = Value(T(precise.expectedValue.me), T(precise.expectedValue.them));
+		s.valid = precise.valid;
+		return s;
+	}
+
+	Strategy solvePrecisely(const PlayerState &me, const PlayerState &them, bool verbose, SweepStats *cached) const {
+		std::array<T, 9> valuesMe;
+		std::array<T, 9> valuesThemT;
+		make_probabilities(valuesMe, me, them);
+		make_probabilities(valuesThemT, them, me);
+		std::array<double, 9> preciseMe;
+		std::array<double, 9> preciseThemT;
+		std::copy(valuesMe.begin(), valuesMe.end(), preciseMe.begin());
+		std::copy(valuesThemT.begin(), valuesThemT.end(), preciseThemT.begin());
+		BasicGame<double, 3, 3> g(&preciseMe, &preciseThemT);
+		for(int i = 0; i < 3; ++ i) {
+			g.coordsMe[i] = i;
+			g.coordsThem[i] = i;
+		}
+		return narrow(solveNash(g, me, them, verbose, cached));
+	}
+
+	Strategy solve(const PlayerState &me, const PlayerState &them, bool verbose) const {
+		Strategy s;
+		if(solveObvious(me, them, s)) {
 			return s;
+		}
+		return solveGame(me, them, verbose);
+	}
+
+	// Writes the strategy for (me, them), and the mirrored strategy for
+	// (them, me) if mirror is set, recording the change of each stored value
+	void store(
+		const PlayerState &me,
+		const PlayerState &them,
+		const Strategy &s,
+		bool mirror,
+		ValueVector &current,
+		DataVector &data,
+		SweepStats &stats
+	) const {
+		// (diffs are taken before writing, as current may be next itself)
+		const std::size_t p1 = valueIndex(me, them);
+		data[2+p1*2  ] = toDat(s.probMe[0]);
+		data[2+p1*2+1] = toDat(s.probMe[0] + s.probMe[1]);
+		stats.addDiff(s.expectedValue.me - next[p1].me);
+		current[p1] = s.expectedValue;
+		++ stats.solved;
+
+		if(mirror) {
+			const std::size_t p2 = valueIndex(them, me);
+			data[2+p2*2  ] = toDat(s.probThem[0]);
+			data[2+p2*2+1] = toDat(s.probThem[0] + s.probThem[1]);
+			stats.addDiff(s.expectedValue.them - next[p2].me);
+			current[p2] = Value(s.expectedValue.them, s.expectedValue.me);
+		}
+	}
+
+	static void reportSupportCache(std::size_t hits, std::size_t misses) {
+		std::cerr
+			<< "Support cache hit for " << hits << " of " << (hits + misses)
+			<< " nash solves (" << (100.0 * hits / std::max<std::size_t>(hits + misses, 1))
+			<< "%)" << std::endl;
+	}
+
+	// Re-solves a spread of mirrored states directly and compares them with
+	// the values and policy bytes filled in from their canonical partner
+	void verifySymmetry(
+		int samples,
+		const ValueVector &current,
+		const DataVector &data,
+		NumT &maxValueDiff,
+		int &maxByteDiff,
+		std::size_t &checked,
+		std::size_t &mismatched
+	) const {
+		std::size_t step = std::max(std::size_t(1), gameStates / std::max(samples, 1));
+		for(std::size_t i = step / 2; i < gameStates; i += step) {
+			auto state = stateFromGameIndex(i);
+			if(playerIndex(state.first) <= playerIndex(state.second)) {
+				continue;
+			}
+			Strategy s = solve(state.first, state.second, false);
+			maxValueDiff = std::max(maxValueDiff, NumT(std::abs(s.expectedValue.me - current[i].me)));
+			int d0 = std::abs(
+				int((unsigned char) toDat(s.probMe[0])) -
+				int((unsigned char) data[2+i*2])
+			);
+			int d1 = std::abs(
+				int((unsigned char) toDat(s.probMe[0] + s.probMe[1])) -
+				int((unsigned char) data[2+i*2+1])
+			);
+			maxByteDiff = std::max(maxByteDiff, std::max(d0, d1));
+			++ checked;
+			if(d0 > 0 || d1 > 0) {
+				// usually a state with several equilibria of equal value,
+				// where findBestMe picks a different one for each side
+				++ mismatched;
+			}
+		}
+	}
+
+	// Writes a table densely, or as a sparse table (see SparseHeader);
+	// returns the size written
+	std::size_t save(const std::string &name, const DataVector &data, bool sparse) const {
+		std::ofstream fs(name.c_str(), std::ios_base::binary);
+		return save(fs, data, sparse);
+	}
+
+	std::size_t save(std::ostream &fs, const DataVector &data, bool sparse) const {
+		if(!sparse) {
+			fs.write(&data[0], data.size());
+			return data.size();
+		}
+
+		const std::size_t words = (gameStates + 63) / 64;
+		std::vector<std::uint64_t> bits(words);
+		std::vector<std::uint32_t> ranks((gameStates + SPARSE_SUPERBLOCK - 1) / SPARSE_SUPERBLOCK);
+		std::vector<char> entries;
+		for(std::size_t i = 0; i < gameStates; ++ i) {
+			if(i % SPARSE_SUPERBLOCK == 0) {
+				ranks[i / SPARSE_SUPERBLOCK] = entries.size() / 2;
+			}
+			auto state = stateFromGameIndex(i);
+			if(obviousCase(state.first, state.second) != NOT_OBVIOUS) {
+				continue;
+			}
+			bits[i / 64] |= std::uint64_t(1) << (i % 64);
+			entries.push_back(data[2+i*2]);
+			entries.push_back(data[2+i*2+1]);
+		}
+
+		SparseHeader header = SparseHeader();
+		std::memcpy(header.magic, SPARSE_MAGIC, sizeof(header.magic));
+		header.balls = balls;
+		header.ducks = ducks;
+		header.stored = entries.size() / 2;
+		fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fs.write(reinterpret_cast<const char*>(&bits[0]), bits.size() * 8);
+		fs.write(reinterpret_cast<const char*>(&ranks[0]), ranks.size() * 4);
+		fs.write(&entries[0], entries.size());
+		return sizeof(header) + bits.size() * 8 + ranks.size() * 4 + entries.size();
+	}
+
+	// Saves turn tables on a background thread, so that the next sweep can
+	// run meanwhile. Each table is copied (the sweeps keep using data), into
+	// one of the buffers the writer has finished with
+	class TableWriter {
+		const BasicGenerator &generator;
+		const bool sparse;
+		std::deque<std::pair<std::string, DataVector>> pending;
+		std::vector<DataVector> spare;
+		bool writing;
+		bool done;
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::thread thread;
+
+		TableWriter(const TableWriter&) = delete;
+		TableWriter &operator=(const TableWriter&) = delete;
+
+		void run(void) {
+			std::unique_lock<std::mutex> lock(mutex);
+			while(true) {
+				changed.wait(lock, [this] () { return done || !pending.empty(); });
+				if(pending.empty()) {
+					return;
+				}
+				std::pair<std::string, DataVector> table = std::move(pending.front());
+				pending.pop_front();
+				writing = true;
+				lock.unlock();
+				generator.save(table.first, table.second, sparse);
+				lock.lock();
+				writing = false;
+				spare.push_back(std::move(table.second));
+				changed.notify_all();
+			}
+		}
+
+	public:
+		TableWriter(const BasicGenerator &generator, bool sparse)
+			: generator(generator)
+			, sparse(sparse)
+			, pending()
+			, spare()
+			, writing(false)
+			, done(false)
+			, mutex()
+			, changed()
+			, thread(&TableWriter::run, this)
+		{}
+
+		~TableWriter(void) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done = true;
+			}
+			changed.notify_all();
+			thread.join();
+		}
+
+		void add(const std::string &name, const DataVector &data) {
+			DataVector buffer;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [this] () { return pending.size() < WRITE_QUEUE; });
+				if(!spare.empty()) {
+					buffer = std::move(spare.back());
+					spare.pop_back();
+				}
+			}
+			buffer.assign(data.begin(), data.end());
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				pending.push_back(std::make_pair(name, std::move(buffer)));
+			}
+			changed.notify_all();
+		}
+
+		// Waits until every table added so far is saved
+		void flush(void) {
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this] () { return pending.empty() && !writing; });
+		}
+	};
+
+	std::size_t tiles(void) const {
+		return (gameStates + TILE - 1) / TILE;
+	}
+
+	void allocate(ValueVector &values) const {
+		values.resize(gameStates);
+		const std::size_t tileCount = tiles();
+		#pragma omp parallel for schedule(static)
+		for(std::size_t tile = 0; tile < tileCount; ++ tile) {
+			const std::size_t end = std::min((tile + 1) * TILE, gameStates);
+			for(std::size_t i = tile * TILE; i < end; ++ i) {
+				values[i] = Value();
+			}
+		}
+	}
+
+	void allocate(DataVector &data) const {
+		data.resize(fileSize());
+		const std::size_t tileCount = tiles();
+		#pragma omp parallel for schedule(static)
+		for(std::size_t tile = 0; tile < tileCount; ++ tile) {
+			const std::size_t end = std::min((tile + 1) * TILE, gameStates);
+			std::fill(data.begin() + 2 + tile * TILE * 2, data.begin() + 2 + end * 2, 0);
+		}
+	}
+
+	// True unless worklist mode is on and no successor of the state moved
+	bool needsSolve(std::size_t meIndex, std::size_t themIndex) const {
+		return dirty.empty() || dirty[meIndex * playerStates + themIndex];
+	}
+
+	// Keeps the previous value (and policy) of a state which does not need
+	// solving; its mirror is kept too if mirror is set
+	void carryForward(
+		std::size_t meIndex,
+		std::size_t themIndex,
+		bool mirror,
+		ValueVector &current
+	) const {
+		const std::size_t p1 = valueIndex(meIndex, themIndex);
+		current[p1] = next[p1];
+		if(mirror) {
+			const std::size_t p2 = valueIndex(themIndex, meIndex);
+			current[p2] = next[p2];
+		}
+	}
+
+	// Finds the states whose value has drifted by more than tolerance since
+	// their predecessors were last re-solved, and flags those predecessors
+	// for the next sweep; returns how many states moved
+	std::size_t markChanged(const ValueVector &current, NumT tolerance) {
+		std::vector<char> moved(gameStates);
+		std::size_t count = 0;
+		#pragma omp parallel for schedule(static) reduction(+:count)
+		for(std::size_t i = 0; i < gameStates; ++ i) {
+			moved[i] = std::max(
+				std::abs(current[i].me - propagated[i].me),
+				std::abs(current[i].them - propagated[i].them)
+			) > tolerance;
+			if(moved[i]) {
+				propagated[i] = current[i];
+				++ count;
+			}
+		}
+
+		// (a few predecessors each, so this is cheap next to the sweep)
+		std::fill(dirty.begin(), dirty.end(), 0);
+		for(std::size_t i = 0; i < gameStates; ++ i) {
+			if(!moved[i]) {
+				continue;
+			}
+			const std::size_t meIndex = i / playerStates;
+			const std::size_t themIndex = i % playerStates;
+			for(std::size_t m = predecessorStart[meIndex]; m < predecessorStart[meIndex + 1]; ++ m) {
+				char *row = &dirty[predecessors[m] * playerStates];
+				for(std::size_t t = predecessorStart[themIndex]; t < predecessorStart[themIndex + 1]; ++ t) {
+					row[predecessors[t]] = 1;
+				}
+			}
+		}
+		return count;
+	}
+
+	void solveState(
+		std::size_t meIndex,
+		std::size_t themIndex,
+		ValueVector &current,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose,
+		SweepStats &stats
+	) const {
+		if(!needsSolve(meIndex, themIndex)) {
+			carryForward(meIndex, themIndex, options.symmetric && meIndex != themIndex, current);
+			return;
+		}
+		const PlayerState me = stateFromPlayerIndex(meIndex);
+		const PlayerState them = stateFromPlayerIndex(themIndex);
+
+		Strategy s;
+		if(!solveObvious(me, them, s) && !solveZeroSum(me, them, options, s, stats)) {
+			s = solveGame(me, them, verbose, &stats);
+		}
+		store(
+			me, them, s,
+			options.symmetric && meIndex != themIndex,
+			current, data, stats
+		);
+	}
+
+	void solveTile(
+		std::size_t begin,
+		std::size_t end,
+		ValueVector &current,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose,
+		SweepStats &stats
+	) const {
+		for(std::size_t i = begin; i < end; ++ i) {
+			const std::size_t meIndex = i / playerStates;
+			const std::size_t themIndex = i % playerStates;
+			if(options.symmetric && meIndex > themIndex) {
+				continue; // filled in from (them, me)
+			}
+			solveState(meIndex, themIndex, current, data, options, verbose, stats);
+		}
+	}
+
+	// Same as solveTile, but queues states which need the nash solver and
+	// solves them BATCH at a time with nash_batch
+	void solveTileBatched(
+		std::size_t begin,
+		std::size_t end,
+		ValueVector &current,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose,
+		SweepStats &stats
+	) const {
+		GameBatch<BATCH, double> batch;
+		StrategyBatch<BATCH, double> result;
+		std::size_t pending[BATCH];
+		int lanes = 0;
+		std::array<T, 9> valuesMe;
+		std::array<T, 9> valuesThemT;
+
+		for(std::size_t i = begin; i <= end; ++ i) {
+			if(i < end) {
+				const std::size_t meIndex = i / playerStates;
+				const std::size_t themIndex = i % playerStates;
+				if(options.symmetric && meIndex > themIndex) {
+					continue; // filled in from (them, me)
+				}
+				if(!needsSolve(meIndex, themIndex)) {
+					carryForward(meIndex, themIndex, options.symmetric && meIndex != themIndex, current);
+					continue;
+				}
+				const PlayerState me = stateFromPlayerIndex(meIndex);
+				const PlayerState them = stateFromPlayerIndex(themIndex);
+
+				Strategy s;
+				if(solveObvious(me, them, s) || solveZeroSum(me, them, options, s, stats)) {
+					store(
+						me, them, s,
+						options.symmetric && meIndex != themIndex,
+						current, data, stats
+					);
+					continue;
+				}
+				make_probabilities(valuesMe, me, them);
+				make_probabilities(valuesThemT, them, me);
+				batch.set(lanes, valuesMe, valuesThemT);
+				pending[lanes ++] = i;
+				if(lanes < BATCH) {
+					continue;
+				}
+			} else if(lanes == 0) {
+				break;
+			}
+
+			// batch is full, or this is the end of the tile
+			for(int l = lanes; l < BATCH; ++ l) {
+				batch.set(l, valuesMe, valuesThemT); // padding
+			}
+			// (timed along with storing the results)
+			TELEMETRY(telemetry().counts[COUNT_BATCHED] += lanes; TelemetryScope scope(TIME_BATCH);)
+			nash_batch(batch, result, verbose, lanes);
+			for(int l = 0; l < lanes; ++ l) {
+				TELEMETRY(telemetry().counts[COUNT_NO_EQUILIBRIUM] += (result.valid[l] == 0);)
+				const std::size_t meIndex = pending[l] / playerStates;
+				const std::size_t themIndex = pending[l] % playerStates;
+				const PlayerState me = stateFromPlayerIndex(meIndex);
+				const PlayerState them = stateFromPlayerIndex(themIndex);
+				store(
+					me, them, narrow(result.lane(l)),
+					options.symmetric && meIndex != themIndex,
+					current, data, stats
+				);
+			}
+			lanes = 0;
+		}
+	}
+
+	// Solves every state once from `next`, filling `current` and `data`
+	SweepStats sweep(
+		ValueVector &current,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose
+	) const {
+		data[0] = balls;
+		data[1] = ducks;
+		const std::size_t tileCount = tiles();
+		SweepStats total;
+		#pragma omp parallel
+		{
+			SweepStats stats; // per thread, merged once at the end
+			#pragma omp for schedule(dynamic, 1) nowait
+			for(std::size_t tile = 0; tile < tileCount; ++ tile) {
+				const std::size_t begin = tile * TILE;
+				const std::size_t end = std::min(begin + TILE, gameStates);
+				if(options.batched) {
+					solveTileBatched(begin, end, current, data, options, verbose, stats);
+				} else {
+					solveTile(begin, end, current, data, options, verbose, stats);
+				}
+			}
+			#pragma omp critical
+			total.add(stats);
+		}
+		return total;
+	}
+
+	// One turn of a best response to a fixed policy for me: policy(me, them)
+	// gives the probability of each of me's actions, and them picks the
+	// action which is worst for me, given the values in next for the turn
+	// after. current gets me's values, and response them's (pure) policy,
+	// stored as (them, me) so that it reads as an ordinary table for them
+	template <typename Policy>
+	SweepStats respond(const Policy &policy, ValueVector &current, DataVector &response) const {
+		response[0] = balls;
+		response[1] = ducks;
+		const std::size_t tileCount = tiles();
+		SweepStats total;
+		#pragma omp parallel
+		{
+			SweepStats stats;
+			std::array<T, 9> g;
+			#pragma omp for schedule(dynamic, 1) nowait
+			for(std::size_t tile = 0; tile < tileCount; ++ tile) {
+				const std::size_t end = std::min((tile + 1) * TILE, gameStates);
+				for(std::size_t i = tile * TILE; i < end; ++ i) {
+					const auto state = stateFromGameIndex(i);
+					const std::array<double, 3> p = policy(state.first, state.second);
+					make_probabilities(g, state.first, state.second);
+					int best = 0;
+					double worst = 2;
+					for(int b = 0; b < 3; ++ b) {
+						const double v = p[0] * g[b] + p[1] * g[3 + b] + p[2] * g[6 + b];
+						if(v < worst) {
+							worst = v;
+							best = b;
+						}
+					}
+					const std::size_t r = gameIndex(state.second, state.first);
+					response[2+r*2  ] = toDat(best == RELOAD);
+					response[2+r*2+1] = toDat(best != DUCK);
+					stats.addDiff(worst - next[i].me);
+					current[i] = Value(T(worst), T(-worst));
+					++ stats.solved;
+				}
+			}
+			#pragma omp critical
+			total.add(stats);
+		}
+		return total;
+	}
+
+	// Works back from turns (a draw) to turn 0 with respond(), adding the
+	// best response for each turn to archive; policy(turn, me, them) is as
+	// for respond(). Every turn is solved, as a response picked from values
+	// which have stopped changing can stall until the turn limit where its
+	// actions tie. Afterwards values() has the values for turn 0
+	template <typename Policy>
+	void bestResponse(int turns, const Policy &policy, ArchiveWriter &archive, bool verbose) {
+		ValueVector current;
+		next.clear();
+		allocate(next);
+		allocate(current);
+		allocate(data);
+		for(std::size_t turn = turns; (turn --) > 0;) {
+			const SweepStats stats = respond(
+				[&policy, turn] (const PlayerState &me, const PlayerState &them) {
+					return policy(int(turn), me, them);
+				},
+				current, data
+			);
+			std::swap(next, current);
+			archive.add(int(turn), data);
+			if(verbose) {
+				std::cerr
+					<< "Turn " << turn << ": values changed by at most " << stats.maxDiff << std::endl;
+			}
+		}
+	}
+
+	// Solves the states where me has dm ducks and them has dt ducks (and the
+	// mirrored slab) in place, passing over them until they stop changing.
+	// Ducks never increase, so all other successors are in slabs with fewer
+	// ducks, which must already be solved. Returns the number of passes
+	int solveSlabPair(
+		int dm,
+		int dt,
+		int maxPasses,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose,
+		SweepStats &stats
+	) {
+		int passes = 0;
+		SweepStats pass;
+		do {
+			pass = SweepStats();
+			passSlabPair(dm, dt, next, data, options, verbose, pass);
+			stats.add(pass);
+			++ passes;
+		} while(pass.maxDiff >= options.tolerance && passes < maxPasses);
+		return passes;
+	}
+
+	// One pass over a slab pair, writing to current
+	void passSlabPair(
+		int dm,
+		int dt,
+		ValueVector &current,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose,
+		SweepStats &stats
+	) const {
+		for(int bm = 0; bm <= balls; ++ bm) {
+			for(int bt = 0; bt <= balls; ++ bt) {
+				for(int flip = 0; flip < ((dm == dt) ? 1 : 2); ++ flip) {
+					const std::size_t meIndex = bm * (ducks + 1) + (flip ? dt : dm);
+					const std::size_t themIndex = bt * (ducks + 1) + (flip ? dm : dt);
+					if(options.symmetric && meIndex > themIndex) {
+						continue; // filled in from (them, me)
+					}
+					solveState(meIndex, themIndex, current, data, options, verbose, stats);
+				}
+			}
+		}
+	}
+
+	// Solves for the values which backward induction converges to, one slab
+	// pair at a time in order of total ducks (pairs with the same total are
+	// independent, so are solved in parallel), updating next in place
+	SweepStats solveStationary(
+		int maxPasses,
+		DataVector &data,
+		const GenerateOptions &options,
+		bool verbose,
+		int &mostPasses
+	) {
+		data[0] = balls;
+		data[1] = ducks;
+		SweepStats total;
+		mostPasses = 0;
+		for(int wave = 0; wave <= ducks * 2; ++ wave) {
+			const int first = std::max(0, wave - ducks);
+			const int count = wave / 2 - first + 1;
+			#pragma omp parallel
+			{
+				SweepStats stats;
+				int threadPasses = 0;
+				#pragma omp for schedule(dynamic, 1) nowait
+				for(int i = 0; i < count; ++ i) {
+					threadPasses = std::max(threadPasses, solveSlabPair(
+						first + i, wave - first - i, maxPasses,
+						data, options, verbose, stats
+					));
+				}
+				#pragma omp critical
+				{
+					total.add(stats);
+					mostPasses = std::max(mostPasses, threadPasses);
+				}
+			}
+		}
+		return total;
+	}
+
+	// The same as generate() with --stationary, but only keeps three rows of
+	// slabs in memory (see valueIndex), and writes each row's entries to a
+	// slab-ordered table as soon as it is solved. Each slab pair gets one
+	// more pass from its final values into a separate window (like the
+	// extra sweep in generate()), which gives the entries and the residual,
+	// so the entries match the stationary nashdata_0.dat exactly
+	bool generateOutOfCore(int maxPasses, const std::string &filename, const GenerateOptions &options, bool verbose) {
+		const std::size_t side = balls + 1;
+		const std::size_t slabStates = side * side;
+		const std::size_t rowStates = slabStates * (ducks + 1);
+		std::ofstream fs(filename.c_str(), std::ios_base::binary);
+		SlabTableHeader header = SlabTableHeader();
+		std::memcpy(header.magic, SLAB_TABLE_MAGIC, sizeof(header.magic));
+		header.balls = balls;
+		header.ducks = ducks;
+		fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		windowed = true;
+		ValueVector current(rowStates * 3);
+		next.assign(rowStates * 3, Value());
+		data.assign(2 + rowStates * 3 * 2, 0);
+		if(verbose) {
+			std::cerr
+				<< "Keeping " << (3 * (ducks + 1)) << " of " << ((ducks + 1) * (ducks + 1))
+				<< " slabs in memory ("
+				<< ((current.size() + next.size()) * sizeof(Value) + data.size()) / (1024 * 1024)
+				<< " MB)" << std::endl;
+		}
+		auto begin = std::chrono::steady_clock::now();
+		SweepStats total;
+		SweepStats last;
+		int mostPasses = 0;
+		for(int wave = 0; wave <= ducks * 2; ++ wave) {
+			const int first = std::max(0, wave - ducks);
+			const int count = wave / 2 - first + 1;
+			const std::size_t row = (wave % 3) * rowStates;
+			// (the row held the slabs of wave - 3)
+			std::fill(next.begin() + row, next.begin() + row + rowStates, Value());
+			#pragma omp parallel
+			{
+				SweepStats stats;
+				SweepStats extra;
+				int threadPasses = 0;
+				#pragma omp for schedule(dynamic, 1) nowait
+				for(int i = 0; i < count; ++ i) {
+					const int dm = first + i;
+					const int dt = wave - dm;
+					threadPasses = std::max(threadPasses, solveSlabPair(
+						dm, dt, maxPasses, data, options, verbose, stats
+					));
+					passSlabPair(dm, dt, current, data, options, verbose, extra);
+				}
+				#pragma omp critical
+				{
+					total.add(stats);
+					last.add(extra);
+					mostPasses = std::max(mostPasses, threadPasses);
+				}
+			}
+			for(int dm = first; dm <= wave - first; ++ dm) {
+				const std::size_t slab = row + dm * slabStates;
+				fs.seekp(sizeof(header) + slabIndex(PlayerState(0, dm), PlayerState(0, wave - dm)) * 2);
+				fs.write(&data[2 + slab * 2], slabStates * 2);
+			}
+			if(verbose) {
+				std::cerr
+					<< "Solved " << (wave + 1) << " of " << (ducks * 2 + 1) << " duck totals after "
+					<< std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()
+					<< " seconds" << std::endl;
+			}
+		}
+		windowed = false;
+		ValueVector().swap(next);
+		DataVector().swap(data);
+		fs.close();
+
+		if(verbose) {
+			std::cerr
+				<< "Solved slabs in place with up to " << mostPasses
+				<< " passes each (" << (double(total.solved) / last.solved + 1) << " sweeps); final residual: "
+				<< last.maxDiff << ", RMSD: " << std::sqrt(last.msd / gameStates) << std::endl;
+		}
+		return bool(fs);
+	}
+
+	std::string slabFilename(const std::string &dir, int dm, int dt) const {
+		return (
+			dir + "/slab_" + std::to_string(balls) +
+			"_" + std::to_string(dm) + "_" + std::to_string(dt) + ".dat"
+		);
+	}
+
+	// Fills in a slab from the cache, if it was solved to within tolerance
+	bool loadSlab(const std::string &dir, int dm, int dt, float tolerance) {
+		std::ifstream fs(slabFilename(dir, dm, dt).c_str(), std::ios_base::binary);
+		SlabHeader header;
+		if(
+			!fs.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			std::memcmp(header.magic, SLAB_MAGIC, sizeof(SLAB_MAGIC)) != 0 ||
+			header.balls != std::uint32_t(balls) ||
+			header.meDucks != std::uint32_t(dm) ||
+			header.themDucks != std::uint32_t(dt) ||
+			header.tolerance > tolerance
+		) {
+			return false;
+		}
+		const std::size_t side = balls + 1;
+		std::vector<double> values(side * side * 2);
+		std::vector<char> entries(side * side * 2);
+		if(
+			!fs.read(reinterpret_cast<char*>(&values[0]), values.size() * sizeof(double)) ||
+			!fs.read(&entries[0], entries.size())
+		) {
+			return false;
+		}
+		for(std::size_t k = 0; k < side * side; ++ k) {
+			const std::size_t i = gameIndex(PlayerState(k / side, dm), PlayerState(k % side, dt));
+			next[i] = Value(T(values[k * 2]), T(values[k * 2 + 1]));
+			data[2 + i * 2] = entries[k * 2];
+			data[2 + i * 2 + 1] = entries[k * 2 + 1];
+		}
+		return true;
+	}
+
+	void saveSlab(const std::string &dir, int dm, int dt, float tolerance) const {
+		const std::size_t side = balls + 1;
+		std::vector<double> values(side * side * 2);
+		std::vector<char> entries(side * side * 2);
+		for(std::size_t k = 0; k < side * side; ++ k) {
+			const std::size_t i = gameIndex(PlayerState(k / side, dm), PlayerState(k % side, dt));
+			values[k * 2] = next[i].me;
+			values[k * 2 + 1] = next[i].them;
+			entries[k * 2] = data[2 + i * 2];
+			entries[k * 2 + 1] = data[2 + i * 2 + 1];
+		}
+		SlabHeader header = SlabHeader();
+		std::memcpy(header.magic, SLAB_MAGIC, sizeof(header.magic));
+		header.balls = balls;
+		header.meDucks = dm;
+		header.themDucks = dt;
+		header.tolerance = tolerance;
+
+		// (renamed into place, so that concurrent calls never read half a slab)
+		const std::string name = slabFilename(dir, dm, dt);
+		const std::string temp = name + "." + std::to_string(getpid()) + ".tmp";
+		{
+			std::ofstream fs(temp.c_str(), std::ios_base::binary);
+			fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			fs.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(double));
+			fs.write(&entries[0], entries.size());
+			if(!fs) {
+				std::remove(temp.c_str());
+				return;
+			}
+		}
+		std::rename(temp.c_str(), name.c_str());
+	}
+
+	// Solves only the slabs which a game with (meDucks, themDucks) can
+	// reach: those with no more ducks on either side, and their mirrors
+	// (which hold the values for `them`). Slab pairs are solved in place in
+	// the same order as solveStationary, and read from and written to the
+	// cache in cacheDir. Within a slab, only states where neither player can
+	// force a win need the solver, which is a narrow band of balls.
+	// Once options.budget seconds have passed (unless it is negative), each
+	// remaining pair gets a single pass and is not cached, so that table()
+	// is usable but rough; returns false if that happened. Can be called
+	// again to extend or finish the table
+	bool solveReachable(
+		int meDucks,
+		int themDucks,
+		const std::string &cacheDir,
+		const GenerateOptions &options
+	) {
+		const auto begin = std::chrono::steady_clock::now();
+		if(finished.empty()) {
+			allocate(next);
+			allocate(data);
+			data[0] = balls;
+			data[1] = ducks;
+			finished.resize((ducks + 1) * (ducks + 1), 0);
+		}
+		mkdir(cacheDir.c_str(), 0777);
+
+		bool complete = true;
+		SweepStats stats;
+		for(int wave = 0; wave <= meDucks + themDucks; ++ wave) {
+			for(int a = std::max(0, wave - ducks); a <= wave / 2; ++ a) {
+				const int b = wave - a;
+				if(!(a <= meDucks && b <= themDucks) && !(b <= meDucks && a <= themDucks)) {
+					continue;
+				}
+				char &done = finished[a * (ducks + 1) + b];
+				if(done || (
+					loadSlab(cacheDir, a, b, options.tolerance) &&
+					(a == b || loadSlab(cacheDir, b, a, options.tolerance))
+				)) {
+					done = 1;
+					continue;
+				}
+				const bool late = options.budget >= 0 && std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - begin
+				).count() > options.budget;
+				solveSlabPair(a, b, late ? 1 : LAZY_MAX_PASSES, data, options, false, stats);
+				if(late) {
+					complete = false;
+				} else {
+					saveSlab(cacheDir, a, b, options.tolerance);
+					saveSlab(cacheDir, b, a, options.tolerance);
+					done = 1;
+				}
+			}
+		}
+		return complete;
+	}
+
+	// 1, 2, 4... up to the maximum thread count
+	static std::vector<int> threadCounts(void) {
+		int maxThreads = 1;
+#ifdef _OPENMP
+		maxThreads = omp_get_max_threads();
+#endif
+		std::vector<int> counts;
+		for(int threads = 1; threads < maxThreads; threads *= 2) {
+			counts.push_back(threads);
+		}
+		counts.push_back(maxThreads);
+		return counts;
+	}
+
+	// Returns the time taken by each of `sweeps` sweeps with this many
+	// threads (the thread count is left set)
+	std::vector<double> timeSweeps(int sweeps, int threads, const GenerateOptions &options) {
+		ValueVector current;
+		DataVector data;
+		allocate(current);
+		allocate(data);
+#ifdef _OPENMP
+		omp_set_num_threads(threads);
+#endif
+		// one untimed sweep so that values (and solve costs) are realistic
+		allocate(next);
+		sweep(current, data, options, false);
+		std::swap(next, current);
+
+		std::vector<double> seconds;
+		for(int i = 0; i < sweeps; ++ i) {
+			auto begin = std::chrono::steady_clock::now();
+			sweep(current, data, options, false);
+			seconds.push_back(std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - begin
+			).count());
+			std::swap(next, current);
+		}
+		return seconds;
+	}
+
+	// Times a few sweeps at each thread count from 1 up to the maximum
+	void scalingReport(int sweeps, const GenerateOptions &options) {
+		const std::vector<int> counts = threadCounts();
+		std::cerr << "threads\tseconds/sweep\tspeedup\tefficiency" << std::endl;
+		double base = 0;
+		for(int threads : counts) {
+			const std::vector<double> times = timeSweeps(sweeps, threads, options);
+			double seconds = 0;
+			for(double t : times) {
+				seconds += t;
+			}
+			seconds /= std::max(sweeps, 1);
+			if(threads == 1) {
+				base = seconds;
+			}
+			std::cerr
+				<< threads << '\t' << seconds
+				<< '\t' << (base / seconds)
+				<< '\t' << (base / seconds / threads) << std::endl;
+		}
+#ifdef _OPENMP
+		omp_set_num_threads(counts.back());
+#endif
+	}
+
+	// Starts the next generate() from these values instead of zero
+	template <typename U>
+	void resume(const BasicValueVector<U> &values) {
+		allocate(next);
+		for(std::size_t i = 0; i < gameStates; ++ i) {
+			next[i] = Value(values[i].me, values[i].them);
+		}
+		resumed = true;
+	}
+
+	// Everything generate() needs to carry on from the turn after this one
+	// (see CheckpointHeader)
+	std::vector<char> checkpoint(std::size_t turn, double sweeps) const {
+		CheckpointHeader header = CheckpointHeader();
+		std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+		header.balls = balls;
+		header.ducks = ducks;
+		header.valueSize = sizeof(T);
+		header.worklist = !dirty.empty();
+		header.supportCache = !supports.empty();
+		header.turn = turn;
+		header.sweeps = sweeps;
+		const std::size_t valueBytes = gameStates * sizeof(Value);
+		std::vector<char> image(
+			sizeof(header) + valueBytes + data.size() +
+			(dirty.empty() ? 0 : gameStates + valueBytes) + supports.size()
+		);
+		char *p = &image[0];
+		std::memcpy(p, &header, sizeof(header));
+		std::memcpy(p += sizeof(header), &next[0], valueBytes);
+		std::memcpy(p += valueBytes, &data[0], data.size());
+		p += data.size();
+		if(!dirty.empty()) {
+			std::memcpy(p, &dirty[0], gameStates);
+			std::memcpy(p += gameStates, &propagated[0], valueBytes);
+			p += valueBytes;
+		}
+		if(!supports.empty()) {
+			std::memcpy(p, &supports[0], supports.size());
+		}
+		return image;
+	}
+
+	// Restores a checkpoint written with the same limits, precision,
+	// worklist and support cache settings; generate() must already have allocated everything
+	bool loadCheckpoint(const std::string &filename, std::size_t &turn, double &sweeps) {
+		std::ifstream fs(filename.c_str(), std::ios_base::binary);
+		CheckpointHeader header;
+		if(
+			!fs.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+			header.balls != std::uint32_t(balls) ||
+			header.ducks != std::uint32_t(ducks) ||
+			header.valueSize != sizeof(T) ||
+			header.worklist != std::uint32_t(!dirty.empty()) ||
+			header.supportCache != std::uint32_t(!supports.empty())
+		) {
+			return false;
+		}
+		// (checked first, so that a short file leaves the values untouched)
+		const std::size_t valueBytes = gameStates * sizeof(Value);
+		const std::size_t size = sizeof(header) + valueBytes + data.size() +
+			(dirty.empty() ? 0 : gameStates + valueBytes) + supports.size();
+		if(!fs.seekg(0, std::ios_base::end) || std::size_t(fs.tellg()) != size) {
+			return false;
+		}
+		fs.seekg(sizeof(header));
+		if(
+			!fs.read(reinterpret_cast<char*>(&next[0]), valueBytes) ||
+			!fs.read(&data[0], data.size()) ||
+			(!dirty.empty() && (
+				!fs.read(&dirty[0], gameStates) ||
+				!fs.read(reinterpret_cast<char*>(&propagated[0]), valueBytes)
+			)) ||
+			(!supports.empty() && !fs.read(reinterpret_cast<char*>(&supports[0]), supports.size()))
+		) {
+			return false;
+		}
+		turn = header.turn;
+		sweeps = header.sweeps;
+		return true;
+	}
+
+	// The values and table from the last turn generated
+	const ValueVector &values(void) const {
+		return next;
+	}
+
+	const DataVector &table(void) const {
+		return data;
+	}
+
+	// Returns the turn which converged, or 0 if it ran out of turns
+	std::size_t generate(
+		int turns,
+		SaveMode saveMode,
+		bool verbose,
+		const GenerateOptions &options = GenerateOptions()
+	) {
+		ValueVector current;
+		if(!resumed) {
+			next.clear();
+			allocate(next);
+		}
+		resumed = false;
+		allocate(current);
+		allocate(data);
+		dirty.clear();
+		propagated.clear();
+		supports.clear();
+		if(options.supportCache) {
+			supports.assign(gameStates, NO_SUPPORT);
+		}
+		if(options.worklist && !options.stationary) {
+			dirty.assign(gameStates, 1); // first sweep solves everything
+			allocate(propagated);
+		}
+		NumT symmetryValueDiff = 0;
+		int symmetryByteDiff = 0;
+		std::size_t symmetryChecked = 0;
+		std::size_t symmetryMismatched = 0;
+		auto begin = std::chrono::steady_clock::now();
+		double sweeps = 0;
+		SweepStats last;
+		std::unique_ptr<ArchiveWriter> archive;
+		std::unique_ptr<TableWriter> writer;
+		if(saveMode == SAVE_ALL && options.archive) {
+			archive.reset(new ArchiveWriter(*this));
+		} else if(saveMode == SAVE_ALL) {
+			writer.reset(new TableWriter(*this, options.sparse));
+		}
+		TELEMETRY(TelemetryLog telemetryLog(balls, ducks, gameStates, options);)
+
+		if(options.stationary) {
+			int mostPasses = 0;
+			const SweepStats stats = solveStationary(turns, data, options, verbose, mostPasses);
+			// one ordinary sweep from the solved values gives the residual,
+			// and policies which all match the final values
+			last = sweep(current, data, options, verbose);
+			TELEMETRY(
+				const auto solved = std::chrono::steady_clock::now();
+				telemetryLog.write("stationary", 0, last, begin, solved, solved, solved);
+			)
+			sweeps = double(stats.solved) / last.solved + 1;
+			if(verbose) {
+				std::cerr
+					<< "Solved slabs in place with up to " << mostPasses
+					<< " passes each" << std::endl;
+				if(options.zeroSum) {
+					std::cerr
+						<< "Zero-sum solver handled " << (stats.zeroSumSolved + last.zeroSumSolved)
+						<< " states (" << (stats.zeroSumFallback + last.zeroSumFallback)
+						<< " fell back to the general solver)" << std::endl;
+				}
+				if(options.supportCache) {
+					reportSupportCache(stats.supportHits + last.supportHits, stats.supportMisses + last.supportMisses);
+				}
+			}
+			if(options.symmetric && options.verifySamples > 0) {
+				verifySymmetry(
+					options.verifySamples, current, data,
+					symmetryValueDiff, symmetryByteDiff, symmetryChecked, symmetryMismatched
+				);
+			}
+			std::swap(next, current);
+			turns = 0; // skip backward induction
+		}
+
+		std::size_t first = turns;
+		if(options.resume && turns > 0) {
+			const std::string name = CheckpointWriter::defaultFilename();
+			if(loadCheckpoint(name, first, sweeps)) {
+				if(verbose) {
+					std::cerr << "Resuming after turn " << first << std::endl;
+				}
+			} else if(verbose) {
+				std::cerr << "No usable " << name << "; starting from the last turn" << std::endl;
+			}
+		}
+		std::unique_ptr<CheckpointWriter> checkpointWriter;
+		if(options.checkpoint > 0 && turns > 0) {
+			checkpointWriter.reset(new CheckpointWriter());
+		}
+
+		std::size_t converged = 0;
+		for(std::size_t turn = first; (turn --) > 0;) {
+			if(verbose) {
+				std::cerr << "Generating for turn " << turn << "..." << std::endl;
+			}
+			TELEMETRY(const auto sweepBegin = std::chrono::steady_clock::now();)
+			const SweepStats stats = sweep(current, data, options, verbose);
+			TELEMETRY(const auto solved = std::chrono::steady_clock::now();)
+			const NumT maxDiff = stats.maxDiff;
+			last = stats;
+			++ sweeps;
+			if(!dirty.empty()) {
+				const std::size_t moved = markChanged(current, options.worklistTolerance);
+				if(verbose) {
+					std::cerr
+						<< "Re-solved " << stats.solved << " states ("
+						<< moved << " moved enough to re-solve their predecessors)" << std::endl;
+				}
+			}
+
+			if(options.symmetric && options.verifySamples > 0) {
+				NumT valueDiff = 0;
+				int byteDiff = 0;
+				verifySymmetry(
+					options.verifySamples, current, data,
+					valueDiff, byteDiff, symmetryChecked, symmetryMismatched
+				);
+				symmetryValueDiff = std::max(symmetryValueDiff, valueDiff);
+				symmetryByteDiff = std::max(symmetryByteDiff, byteDiff);
+				if(verbose) {
+					std::cerr
+						<< "Mirrored states differ from a full solve by at most "
+						<< valueDiff << " (policy bytes: " << byteDiff << ")" << std::endl;
+				}
+			}
+
+			TELEMETRY(const auto written = std::chrono::steady_clock::now();)
+			if(archive) {
+				archive->add(turn, data);
+			} else if(writer) {
+				writer->add(filename(turn), data);
+			}
+			TELEMETRY(telemetryLog.write(
+				"sweep", turn, stats,
+				sweepBegin, solved, written, std::chrono::steady_clock::now()
+			);)
+
+			if(verbose) {
+				std::cerr
+					<< "Expectations changed by at most " << maxDiff
+					<< " (RMSD: " << std::sqrt(stats.msd / gameStates) << ")" << std::endl;
+				if(options.zeroSum) {
+					std::cerr
+						<< "Zero-sum solver handled " << stats.zeroSumSolved
+						<< " states (" << stats.zeroSumFallback
+						<< " fell back to the general solver)" << std::endl;
+				}
+				if(options.supportCache) {
+					reportSupportCache(stats.supportHits, stats.supportMisses);
+				}
+			}
+			std::swap(next, current);
+			if(maxDiff < options.tolerance) {
+				if(verbose) {
+					std::cerr << "Expectations have converged. Stopping." << std::endl;
+				}
+				converged = turn;
+				break;
+			}
+			if(checkpointWriter && turn % options.checkpoint == 0) {
+				// (a checkpoint must never be ahead of the saved turns)
+				if(writer) {
+					writer->flush();
+				}
+				checkpointWriter->write(checkpoint(turn, sweeps));
+			}
+		}
+		if(checkpointWriter) {
+			if(!checkpointWriter->wait()) {
+				std::cerr << "Failed to write a checkpoint" << std::endl;
+			}
+			checkpointWriter->remove();
+		}
+
+		if(verbose) {
+			std::cerr
+				<< "Finished after " << sweeps << " sweeps in "
+				<< std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()
+				<< " seconds (final residual: " << last.maxDiff
+				<< ", RMSD: " << std::sqrt(last.msd / gameStates) << ")" << std::endl;
+		}
+
+		if(archive) {
+			const std::uint64_t size = archive->finish();
+			if(verbose && size > 0) {
+				std::cerr
+					<< "Archived " << std::size_t(sweeps) << " turns as "
+					<< archive->tableCount() << " tables (" << archive->keyframeCount()
+					<< " keyframes) in " << size << " bytes, "
+					<< (100.0 * size / (std::size_t(sweeps) * fileSize()))
+					<< "% of separate files" << std::endl;
+			}
+		}
+
+		if(options.symmetric && options.verifySamples > 0 && verbose) {
+			std::cerr
+				<< "Symmetry check: values differ by at most " << symmetryValueDiff
+				<< ", policy bytes by at most " << symmetryByteDiff
+				<< " (" << symmetryMismatched << " of " << symmetryChecked
+				<< " sampled states chose a different strategy)" << std::endl;
+		}
+
+		// (the last turn could be 0 too)
+		writer.reset();
+
+		if(saveMode == SAVE_NOTHING) {
+			return converged;
+		}
+		// Always save turn 0 with the final converged expectations
+		const std::size_t size = save(filename(0), data, options.sparse);
+		if(options.sparse && verbose) {
+			std::cerr
+				<< "Saved sparse tables (" << size << " bytes, "
+				<< (100.0 * size / fileSize()) << "% of a dense table)" << std::endl;
+		}
+		return converged;
+	}
+};
+
+typedef BasicGenerator<NumT> Generator;
+
+// in mixed precision, float sweeps stop at this multiple of the tolerance
+static const NumT MIXED_HANDOVER = 10;
+
+template <typename T>
+void comparePrecision(const BasicGenerator<T> &g, const Generator &reference) {
+	const DataVector &a = g.table();
+	const DataVector &b = reference.table();
+	int maxByteDiff = 0;
+	std::size_t differ = 0;
+	for(std::size_t i = 2; i < a.size(); ++ i) {
+		const int d = std::abs(int((unsigned char) a[i]) - int((unsigned char) b[i]));
+		maxByteDiff = std::max(maxByteDiff, d);
+		differ += (d > 0);
+	}
+	NumT maxValueDiff = 0;
+	for(std::size_t i = 0; i < g.values().size(); ++ i) {
+		maxValueDiff = std::max(
+			maxValueDiff,
+			std::abs(NumT(g.values()[i].me) - reference.values()[i].me)
+		);
+	}
+	std::cerr
+		<< "Compared with double precision: policy bytes differ by at most "
+		<< maxByteDiff << " (" << differ << " of " << (a.size() - 2)
+		<< " bytes differ), values by at most " << maxValueDiff << std::endl;
+}
+
+// Generates with the scalar type chosen in options
+void generateTables(int turns, int maxBalls, int maxDucks, const GenerateOptions &options) {
+	std::unique_ptr<Generator> reference;
+	if(options.precisionReport && options.precision != PRECISION_DOUBLE) {
+		std::cerr << "Generating in double precision for comparison..." << std::endl;
+		reference.reset(new Generator(maxBalls, maxDucks));
+		reference->generate(turns, SAVE_NOTHING, false, options.withoutCheckpoint());
+	}
+
+	if(options.precision == PRECISION_DOUBLE) {
+		Generator(maxBalls, maxDucks).generate(turns, SAVE_ALL, true, options);
+	} else if(options.precision == PRECISION_FLOAT) {
+		BasicGenerator<float> g(maxBalls, maxDucks);
+		g.generate(turns, SAVE_ALL, true, options);
+		if(reference) {
+			comparePrecision(g, *reference);
+		}
+	} else {
+		GenerateOptions coarse = options;
+		coarse.tolerance *= MIXED_HANDOVER;
+		std::cerr << "Sweeping in float precision..." << std::endl;
+		BasicGenerator<float> g(maxBalls, maxDucks);
+		std::size_t turn = g.generate(turns, SAVE_ALL, true, coarse);
+		std::cerr << "Finishing in double precision..." << std::endl;
+		Generator fine(maxBalls, maxDucks);
+		fine.resume(g.values());
+		fine.generate(options.stationary ? turns : std::max<std::size_t>(turn, 1), SAVE_ALL, true, options);
+		if(reference) {
+			comparePrecision(fine, *reference);
+		}
+	}
+}
+
+static const char *MASTER_FILE = "nashmaster.dat";
+static const char *SLAB_TABLE_FILE = "nashdata.slb";
+
+void generateMaster(int turns, int maxBalls, int maxDucks, const GenerateOptions &options) {
+	MasterHeader header = MasterHeader();
+	std::memcpy(header.magic, MASTER_MAGIC, sizeof(header.magic));
+	header.balls = maxBalls;
+	header.ducks = maxDucks;
+	std::vector<std::uint64_t> offsets(maxBalls);
+
+	const std::string temp = std::string(MASTER_FILE) + "." + std::to_string(getpid()) + ".tmp";
+	std::ofstream fs(temp.c_str(), std::ios_base::binary);
+	fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fs.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size() * sizeof(std::uint64_t));
+	const GenerateOptions single = options.withoutCheckpoint();
+	auto begin = std::chrono::steady_clock::now();
+	for(int b = 1; b <= maxBalls; ++ b) {
+		Generator g(b, maxDucks);
+		g.generate(turns, SAVE_NOTHING, false, single);
+		offsets[b - 1] = fs.tellp();
+		fs.write(&g.table()[0], g.table().size());
+		std::cerr
+			<< "Ball limit " << b << " of " << maxBalls << " done after "
+			<< std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()
+			<< " seconds" << std::endl;
+	}
+	fs.seekp(sizeof(header));
+	fs.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size() * sizeof(std::uint64_t));
+	fs.close();
+	if(!fs || std::rename(temp.c_str(), MASTER_FILE) != 0) {
+		std::cerr << "Failed to write " << MASTER_FILE << std::endl;
+		std::remove(temp.c_str());
+	}
+}
+
+void generateOutOfCore(int passes, int maxBalls, int maxDucks, const GenerateOptions &options) {
+	bool ok;
+	if(options.precision == PRECISION_FLOAT) {
+		ok = BasicGenerator<float>(maxBalls, maxDucks).generateOutOfCore(passes, SLAB_TABLE_FILE, options, true);
+	} else {
+		ok = Generator(maxBalls, maxDucks).generateOutOfCore(passes, SLAB_TABLE_FILE, options, true);
+	}
+	if(!ok) {
+		std::cerr << "Failed to write " << SLAB_TABLE_FILE << std::endl;
+	}
+}
+
+void testZeroSum(void) {
+	// minimax must find optimal strategies for both sides, with the same
+	// value as the general solver
+	std::mt19937 rand(2);
+	std::uniform_int_distribution<int> smallInt(-1, 1);
+	std::uniform_real_distribution<NumT> real(-1, 1);
+	NumT worstGap = 0;
+	NumT worstValueDiff = 0;
+	std::size_t failures = 0;
+	const int count = 10000;
+	for(int i = 0; i < count; ++ i) {
+		std::array<NumT, 9> valuesMe;
+		std::array<NumT, 9> valuesThemT;
+		for(int k = 0; k < 9; ++ k) {
+			valuesMe[k] = (i % 2) ? real(rand) : smallInt(rand);
+		}
+		for(int k = 0; k < 9; ++ k) {
+			valuesThemT[k] = -valuesMe[k % 3 * 3 + k / 3];
+		}
+		Strategy s = minimax(valuesMe);
+		if(!s.valid) {
+			++ failures;
+			continue;
+		}
+		const NumT v = s.expectedValue.me;
+		for(int t = 0; t < 3; ++ t) {
+			// no reply by `them` may push `me` below the value...
+			NumT exp = 0;
+			for(int m = 0; m < 3; ++ m) {
+				exp += s.probMe[m] * valuesMe[m * 3 + t];
+			}
+			worstGap = std::max(worstGap, v - exp);
+		}
+		for(int m = 0; m < 3; ++ m) {
+			// ...and no reply by `me` may beat it
+			NumT exp = 0;
+			for(int t = 0; t < 3; ++ t) {
+				exp += s.probThem[t] * valuesMe[m * 3 + t];
+			}
+			worstGap = std::max(worstGap, exp - v);
+		}
+
+		Game<3, 3> g(&valuesMe, &valuesThemT);
+		for(int k = 0; k < 3; ++ k) {
+			g.coordsMe[k] = k;
+			g.coordsThem[k] = k;
+		}
+		Strategy general = nash(g, false);
+		if(general.valid) {
+			worstValueDiff = std::max(worstValueDiff, std::abs(general.expectedValue.me - v));
+		}
+	}
+	std::cerr
+		<< "Zero-sum solver: " << (count - failures) << " of " << count
+		<< " games solved, strategies within " << worstGap
+		<< " of optimal, values within " << worstValueDiff
+		<< " of the general solver" << std::endl;
+}
+
+// the fixed games, then 10000 random ones
+template <typename T>
+std::vector<std::pair<std::array<T, 9>, std::array<T, 9>>> testGames(
+	const std::vector<std::pair<std::array<NumT, 9>, std::array<NumT, 9>>> &fixed
+) {
+	std::vector<std::pair<std::array<T, 9>, std::array<T, 9>>> cases;
+	for(const auto &c : fixed) {
+		std::array<T, 9> valuesMe;
+		std::array<T, 9> valuesThemT;
+		std::copy(c.first.begin(), c.first.end(), valuesMe.begin());
+		std::copy(c.second.begin(), c.second.end(), valuesThemT.begin());
+		cases.push_back(std::make_pair(valuesMe, valuesThemT));
+	}
+	std::mt19937 rand(1);
+	std::uniform_int_distribution<int> smallInt(-1, 1);
+	std::uniform_real_distribution<T> real(-1, 1);
+	for(int i = 0; i < 10000; ++ i) {
+		// small integers give plenty of ties and degenerate games
+		std::array<T, 9> valuesMe;
+		std::array<T, 9> valuesThemT;
+		for(int k = 0; k < 9; ++ k) {
+			valuesMe[k] = (i % 2) ? real(rand) : smallInt(rand);
+			valuesThemT[k] = (i % 4 == 0) ? -valuesMe[k % 3 * 3 + k / 3] : (i % 2) ? real(rand) : smallInt(rand);
+		}
+		cases.push_back(std::make_pair(valuesMe, valuesThemT));
+	}
+	return cases;
+}
+
+template <typename T>
+void testBatch(const std::vector<std::pair<std::array<NumT, 9>, std::array<NumT, 9>>> &fixed) {
+	// nash_batch must match nash() bit-for-bit, for each lane independently
+	const int N = 64 / sizeof(T);
+	const std::vector<std::pair<std::array<T, 9>, std::array<T, 9>>> cases = testGames<T>(fixed);
+
+	std::size_t mismatches = 0;
+	for(std::size_t start = 0; start < cases.size(); start += N) {
+		GameBatch<N, T> batch;
+		const int lanes = std::min(cases.size() - start, std::size_t(N));
+		for(int l = 0; l < N; ++ l) {
+			const auto &c = cases[start + (l < lanes ? l : 0)];
+			batch.set(l, c.first, c.second);
+		}
+		StrategyBatch<N, T> result;
+		nash_batch(batch, result, false);
+
+		for(int l = 0; l < lanes; ++ l) {
+			std::array<T, 9> valuesMe = cases[start + l].first;
+			std::array<T, 9> valuesThemT = cases[start + l].second;
+			BasicGame<T, 3, 3> g(&valuesMe, &valuesThemT);
+			for(int i = 0; i < 3; ++ i) {
+				g.coordsMe[i] = i;
+				g.coordsThem[i] = i;
+			}
+			BasicStrategy<T> expected = nash(g, false);
+			if(!sameBits(expected, result.lane(l))) {
+				if(mismatches == 0) {
+					std::cerr << "Batched solver mismatch:" << std::endl;
+					debugGame(g);
+					debugStrategy(expected);
+					debugStrategy(result.lane(l));
+				}
+				++ mismatches;
+			}
+		}
+	}
+	std::cerr
+		<< "Batched solver (" << (sizeof(T) * 8) << "-bit): " << (cases.size() - mismatches) << " of " << cases.size()
+		<< " games match the scalar solver exactly" << std::endl;
+}
+
+void testSupportCache(const std::vector<std::pair<std::array<NumT, 9>, std::array<NumT, 9>>> &fixed) {
+	// with nothing cached, nash_cached must search like nash(), and the
+	// support it keeps must then hit and give the same strategy again
+	const std::vector<std::pair<std::array<NumT, 9>, std::array<NumT, 9>>> cases = testGames<NumT>(fixed);
+	std::size_t mismatches = 0;
+	for(const auto &c : cases) {
+		std::array<NumT, 9> valuesMe = c.first;
+		std::array<NumT, 9> valuesThemT = c.second;
+		Game<3, 3> g(&valuesMe, &valuesThemT);
+		for(int i = 0; i < 3; ++ i) {
+			g.coordsMe[i] = i;
+			g.coordsThem[i] = i;
+		}
+		const Strategy expected = nash(g, false);
+		std::uint8_t support = NO_SUPPORT;
+		bool hit;
+		const Strategy searched = nash_cached(g, false, support, hit);
+		bool ok = !hit && sameBits(expected, searched) && (support == NO_SUPPORT) == !expected.valid;
+		if(ok && expected.valid) {
+			ok = sameBits(expected, nash_cached(g, false, support, hit)) && hit;
+		}
+		mismatches += !ok;
+	}
+	std::cerr
+		<< "Support cache: " << (cases.size() - mismatches) << " of " << cases.size()
+		<< " games match the full search, and hit on the second solve" << std::endl;
+}
+
+void test(void) {
+	std::array<NumT, 9> valuesMe;
+	std::array<NumT, 9> valuesThemT;
+	Game<3, 3> g(&valuesMe, &valuesThemT);
+	for(int i = 0; i < 3; ++ i) {
+		g.coordsMe[i] = i;
+		g.coordsThem[i] = i;
+	}
+
+	std::vector<std::pair<std::array<NumT, 9>, std::array<NumT, 9>>> cases;
+
+	Game<2, 2> g2(&valuesMe, &valuesThemT);
+	for(int i = 0; i < 2; ++ i) {
+		g2.coordsMe[i] = i;
+		g2.coordsThem[i] = i;
+	}
+
+	std::cerr << "Testing rock, paper, scissors:" << std::endl;
+	valuesMe[0] = 0; valuesMe[1] =-1; valuesMe[2] = 1;
+	valuesMe[3] = 1; valuesMe[4] = 0; valuesMe[5] =-1;
+	valuesMe[6] =-1; valuesMe[7] = 1; valuesMe[8] = 0;
+
+	valuesThemT[0] = 0; valuesThemT[1] =-1; valuesThemT[2] = 1;
+	valuesThemT[3] = 1; valuesThemT[4] = 0; valuesThemT[5] =-1;
+	valuesThemT[6] =-1; valuesThemT[7] = 1; valuesThemT[8] = 0;
+
+	debugGame(g);
+	debugStrategy(nash(g, true));
+	cases.push_back(std::make_pair(valuesMe, valuesThemT));
+
+	std::cerr << "Testing chicken (L, C, R):" << std::endl;
+	valuesMe[0] = 0; valuesMe[1] =-1; valuesMe[2] =-10;
+	valuesMe[3] = 1; valuesMe[4] =-10; valuesMe[5] = 1;
+	valuesMe[6] =-10; valuesMe[7] =-1; valuesMe[8] = 0;
+
+	valuesThemT[0] = 0; valuesThemT[1] =-1; valuesThemT[2] =-10;
+	valuesThemT[3] = 1; valuesThemT[4] =-10; valuesThemT[5] = 1;
+	valuesThemT[6] =-10; valuesThemT[7] =-1; valuesThemT[8] = 0;
+
+	debugGame(g);
+	debugStrategy(nash(g, true));
+	cases.push_back(std::make_pair(valuesMe, valuesThemT));
+
+	std::cerr << "Testing chicken (L, C):" << std::endl;
+	debugGame(g2);
+	debugStrategy(nash(g2, true));
+
+	std::cerr << "Testing online example:" << std::endl;
+	valuesMe[0] = 1; valuesMe[1] = 10; valuesMe[2] =-10;
+	valuesMe[3] = 0; valuesMe[4] = 1; valuesMe[5] = 10;
+	valuesMe[6] = 1; valuesMe[7] = 1; valuesMe[8] = 1;
+
+	valuesThemT[0] = 1; valuesThemT[1] = 10; valuesThemT[2] =-10;
+	valuesThemT[3] = 0; valuesThemT[4] = 1; valuesThemT[5] = 10;
+	valuesThemT[6] = 1; valuesThemT[7] = 1; valuesThemT[8] = 1;
+
+	debugGame(g);
+	debugStrategy(nash(g, true));
+	cases.push_back(std::make_pair(valuesMe, valuesThemT));
+
+	std::cerr << "Testing online example 2 (clear pure strategy):" << std::endl;
+	valuesMe[0] = 3; valuesMe[1] = 3; valuesMe[2] = 2;
+	valuesMe[3] = 1; valuesMe[4] = 3; valuesMe[5] = 0;
+	valuesMe[6] = 0; valuesMe[7] = 0; valuesMe[8] = 3;
+
+	valuesThemT[0] = 2; valuesThemT[1] = 0; valuesThemT[2] = 2;
+	valuesThemT[3] = 0; valuesThemT[4] = 3; valuesThemT[5] = 0;
+	valuesThemT[6] = 2; valuesThemT[7] = 3; valuesThemT[8] = 2;
+
+	debugGame(g);
+	debugStrategy(nash(g, true));
+	cases.push_back(std::make_pair(valuesMe, valuesThemT));
+
+	std::cerr << "Testing online example 3 (mixed > pure):" << std::endl;
+	valuesMe[0] = 1; valuesMe[1] = 0; valuesMe[2] = 0;
+	valuesMe[3] = 0; valuesMe[4] = 0; valuesMe[5] = 3;
+	valuesMe[6] = 0; valuesMe[7] = 2; valuesMe[8] = 0;
+
+	valuesThemT[0] = 1; valuesThemT[1] = 0; valuesThemT[2] = 0;
+	valuesThemT[3] = 0; valuesThemT[4] = 2; valuesThemT[5] = 0;
+	valuesThemT[6] = 0; valuesThemT[7] = 0; valuesThemT[8] = 3;
+
+	debugGame(g);
+	debugStrategy(nash(g, true));
+	cases.push_back(std::make_pair(valuesMe, valuesThemT));
+
+	std::cerr << "Testing prisoner's dilemma:" << std::endl;
+	valuesMe[0] =-1; valuesMe[1] =-3;
+	valuesMe[3] = 0; valuesMe[4] =-2;
+
+	valuesThemT[0] =-1; valuesThemT[1] =-3;
+	valuesThemT[3] = 0; valuesThemT[4] =-2;
+
+	debugGame(g2);
+	debugStrategy(nash(g2, true));
+
+	std::cerr << "Testing problematic grid:" << std::endl;
+	valuesMe[0] =-0.5; valuesMe[1] =-1; valuesMe[2] = 0;
+	valuesMe[3] = 1; valuesMe[4] =-0.5; valuesMe[5] =-0.75;
+	valuesMe[6] =-1; valuesMe[7] =-0.5; valuesMe[8] =-0.75;
+
+	valuesThemT[0] = 0.5; valuesThemT[1] =-1; valuesThemT[2] = 1;
+	valuesThemT[3] = 1; valuesThemT[4] = 0.5; valuesThemT[5] = 0.5;
+	valuesThemT[6] = 0; valuesThemT[7] = 0.75; valuesThemT[8] = 0.75;
+
+	debugGame(g);
+	debugStrategy(nash(g, true));
+	cases.push_back(std::make_pair(valuesMe, valuesThemT));
+
+	testBatch<double>(cases);
+	testBatch<float>(cases);
+	testSupportCache(cases);
+	testZeroSum();
+}
+
+class MappedFile {
+	void *addr;
+	std::size_t length;
+	// set for a table held in memory instead of mapped from a file
+	std::vector<char> copy;
+	// set for a table compiled into the binary (see EmbeddedTable)
+	const unsigned char *view;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+public:
+	explicit MappedFile(const std::string &filename)
+		: addr(NULL)
+		, length(0)
+		, copy()
+		, view(NULL)
+	{
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if(fd < 0) {
+			return;
+		}
+		struct stat st;
+		if(fstat(fd, &st) == 0 && st.st_size > 0) {
+			// MAP_SHARED: every process using this file reads the same
+			// page cache copy
+			void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if(p != MAP_FAILED) {
+				addr = p;
+				length = st.st_size;
+			}
+		}
+		::close(fd);
+	}
+
+	MappedFile(const char *table, std::size_t size)
+		: addr(NULL)
+		, length(0)
+		, copy(table, table + size)
+		, view(NULL)
+	{}
+
+	// (not copied, as it lives as long as the process)
+	MappedFile(const unsigned char *table, std::size_t size)
+		: addr(NULL)
+		, length(size)
+		, copy()
+		, view(table)
+	{}
+
+	~MappedFile(void) {
+		if(addr) {
+			munmap(addr, length);
+		}
+	}
+
+	const unsigned char *data(void) const {
+		if(!copy.empty()) {
+			return reinterpret_cast<const unsigned char*>(&copy[0]);
+		}
+		if(view) {
+			return view;
+		}
+		return static_cast<const unsigned char*>(addr);
+	}
+
+	std::size_t size(void) const {
+		return copy.empty() ? length : copy.size();
+	}
+
+	void advise(int advice) const {
+		if(addr) {
+			madvise(addr, length, advice);
+		}
+	}
+};
+
+class PolicyTable {
+	std::shared_ptr<const MappedFile> file;
+	const GameStore store;
+	// archived tables only: the block offsets for this table and its keyframe
+	const std::uint64_t *blocks;
+	const std::uint64_t *keyframe;
+	// sparse tables only (see SparseHeader), and the entries of left out
+	// states: win, reload, then a flailing loss for each player state
+	const std::uint64_t *words;
+	const std::uint32_t *ranks;
+	const unsigned char *entries;
+	std::vector<unsigned char> obvious;
+	// where the dense table starts (only not 0 in a master table)
+	std::size_t base;
+	// set for a slab-ordered table (see SlabTableHeader)
+	bool slabbed;
+	bool valid;
+
+	static const SparseHeader *sparseHeader(const MappedFile &f) {
+		if(
+			f.size() < sizeof(SparseHeader) ||
+			std::memcmp(f.data(), SPARSE_MAGIC, sizeof(SPARSE_MAGIC)) != 0
+		) {
+			return NULL;
+		}
+		return reinterpret_cast<const SparseHeader*>(f.data());
+	}
+
+	static const ArchiveHeader *archiveHeader(const MappedFile &f) {
+		if(
+			f.size() < sizeof(ArchiveHeader) ||
+			std::memcmp(f.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0
+		) {
+			return NULL;
+		}
+		return reinterpret_cast<const ArchiveHeader*>(f.data());
+	}
+
+	static const MasterHeader *masterHeader(const MappedFile &f) {
+		if(
+			f.size() < sizeof(MasterHeader) ||
+			std::memcmp(f.data(), MASTER_MAGIC, sizeof(MASTER_MAGIC)) != 0
+		) {
+			return NULL;
+		}
+		return reinterpret_cast<const MasterHeader*>(f.data());
+	}
+
+	static const SlabTableHeader *slabTableHeader(const MappedFile &f) {
+		if(
+			f.size() < sizeof(SlabTableHeader) ||
+			std::memcmp(f.data(), SLAB_TABLE_MAGIC, sizeof(SLAB_TABLE_MAGIC)) != 0
+		) {
+			return NULL;
+		}
+		return reinterpret_cast<const SlabTableHeader*>(f.data());
+	}
+
+	static GameStore layoutOf(const MappedFile &f) {
+		if(const SlabTableHeader *h = slabTableHeader(f)) {
+			return GameStore(h->balls, h->ducks);
+		}
+		if(const ArchiveHeader *h = archiveHeader(f)) {
+			return GameStore(h->balls, h->ducks);
+		}
+		if(const SparseHeader *h = sparseHeader(f)) {
+			return GameStore(h->balls, h->ducks);
+		}
+		return GameStore(
+			(f.size() >= 2) ? f.data()[0] : 0,
+			(f.size() >= 2) ? f.data()[1] : 0
+		);
+	}
+
+	// Finds the entry at offset within an archived block
+	const unsigned char *archived(std::size_t block, std::size_t offset, bool patched) const {
+		const std::uint64_t pos = (patched ? blocks : keyframe)[block];
+		if(pos >= file->size()) {
+			return NULL;
+		}
+		const unsigned char *p = file->data() + pos;
+		const unsigned char *end = file->data() + file->size();
+		if(*p == ARCHIVE_PATCH) {
+			if(p + 3 > end) {
+				return NULL;
+			}
+			const std::size_t count = p[1] | (p[2] << 8);
+			p += 3;
+			for(std::size_t i = 0; i < count && p + 3 <= end && p[0] <= offset; ++ i, p += 3) {
+				if(p[0] == offset) {
+					return p + 1;
+				}
+			}
+			return patched ? archived(block, offset, false) : NULL;
+		}
+		for(++ p; p + 3 <= end; p += 3) {
+			if(offset < p[0]) {
+				return p + 1;
+			}
+			offset -= p[0];
+		}
+		return NULL;
+	}
+
+	void openSparse(const SparseHeader &h) {
+		const std::size_t states = store.fileSize() / 2 - 1;
+		const std::size_t wordCount = (states + 63) / 64;
+		const std::size_t rankCount = (states + SPARSE_SUPERBLOCK - 1) / SPARSE_SUPERBLOCK;
+		if(file->size() != sizeof(SparseHeader) + wordCount * 8 + rankCount * 4 + h.stored * 2) {
+			return;
+		}
+		words = reinterpret_cast<const std::uint64_t*>(file->data() + sizeof(SparseHeader));
+		ranks = reinterpret_cast<const std::uint32_t*>(words + wordCount);
+		entries = reinterpret_cast<const unsigned char*>(ranks + rankCount);
+
+		obvious.push_back(GameStore::toDat(0)); // win: always throw
+		obvious.push_back(GameStore::toDat(1));
+		obvious.push_back(GameStore::toDat(1)); // always reload
+		obvious.push_back(GameStore::toDat(1));
+		for(int b = 0; b <= store.maxBalls(); ++ b) {
+			for(int d = 0; d <= store.maxDucks(); ++ d) {
+				std::array<double, 3> p = PlayerState(b, d).flail(store.maxBalls());
+				obvious.push_back(GameStore::toDat(p[0]));
+				obvious.push_back(GameStore::toDat(p[0] + p[1]));
+			}
+		}
+		valid = true;
+	}
+
+	const unsigned char *sparseEntry(const PlayerState &me, const PlayerState &them) const {
+		switch(obviousCase(me, them)) {
+		case OBVIOUS_WIN: return &obvious[0];
+		case OBVIOUS_RELOAD: return &obvious[2];
+		case OBVIOUS_LOSS: return &obvious[4 + store.playerIndex(me) * 2];
+		default: break;
+		}
+		const std::size_t i = store.gameIndex(me, them);
+		const std::uint64_t bit = std::uint64_t(1) << (i % 64);
+		std::size_t rank = ranks[i / SPARSE_SUPERBLOCK];
+		for(std::size_t w = i / SPARSE_SUPERBLOCK * (SPARSE_SUPERBLOCK / 64); w < i / 64; ++ w) {
+			rank += __builtin_popcountll(words[w]);
+		}
+		rank += __builtin_popcountll(words[i / 64] & (bit - 1));
+		return entries + rank * 2;
+	}
+
+public:
+	explicit PolicyTable(const std::string &filename)
+		: PolicyTable(std::make_shared<MappedFile>(filename))
+	{}
+
+	// A dense, sparse or slab-ordered table
+	explicit PolicyTable(const std::shared_ptr<const MappedFile> &table)
+		: file(table)
+		, store(layoutOf(*file))
+		, blocks(NULL)
+		, keyframe(NULL)
+		, words(NULL)
+		, ranks(NULL)
+		, entries(NULL)
+		, obvious()
+		, base(0)
+		, slabbed(slabTableHeader(*file) != NULL)
+		, valid(
+			!archiveHeader(*file) && !sparseHeader(*file) && !masterHeader(*file) && !slabbed &&
+			file->size() >= 2 && file->size() == store.fileSize()
+		)
+	{
+		if(const SparseHeader *h = sparseHeader(*file)) {
+			openSparse(*h);
+		}
+		if(slabbed) {
+			valid = (file->size() == sizeof(SlabTableHeader) + (store.fileSize() - 2));
+		}
+	}
+
+	// The table for a turn in an archive (see ArchiveWriter)
+	PolicyTable(const std::shared_ptr<const MappedFile> &archive, int turn)
+		: file(archive)
+		, store(layoutOf(*file))
+		, blocks(NULL)
+		, keyframe(NULL)
+		, words(NULL)
+		, ranks(NULL)
+		, entries(NULL)
+		, obvious()
+		, base(0)
+		, slabbed(false)
+		, valid(false)
+	{
+		const ArchiveHeader *h = archiveHeader(*file);
+		if(!h || turn < 0 || std::uint32_t(turn) >= h->turns) {
+			return;
+		}
+		const std::size_t states = store.fileSize() / 2 - 1;
+		const std::size_t tableSize = 1 + (states + ARCHIVE_BLOCK - 1) / ARCHIVE_BLOCK;
+		const std::uint64_t tablesOffset = h->indexOffset + h->ranges * sizeof(ArchiveRange);
+		if(tablesOffset + h->tables * tableSize * 8 > file->size()) {
+			return;
+		}
+		const ArchiveRange *ranges = reinterpret_cast<const ArchiveRange*>(
+			file->data() + h->indexOffset
+		);
+		const ArchiveRange *range = std::upper_bound(
+			ranges, ranges + h->ranges, std::uint32_t(turn),
+			[] (std::uint32_t t, const ArchiveRange &r) { return t < r.first; }
+		);
+		if(range == ranges || std::uint32_t(turn) > (-- range)->last || range->table >= h->tables) {
+			return;
+		}
+		const std::uint64_t *tables = reinterpret_cast<const std::uint64_t*>(
+			file->data() + tablesOffset
+		);
+		blocks = tables + range->table * tableSize;
+		if(blocks[0] >= h->tables) {
+			return;
+		}
+		keyframe = tables + blocks[0] * tableSize + 1;
+		++ blocks;
+		valid = true;
+	}
+
+	// The table for a ball limit in a master table (see generateMaster)
+	PolicyTable(const std::shared_ptr<const MappedFile> &master, int maxBalls, int maxDucks)
+		: file(master)
+		, store(
+			(masterHeader(*file) && maxBalls >= 1 && std::uint32_t(maxBalls) <= masterHeader(*file)->balls)
+			? GameStore(maxBalls, masterHeader(*file)->ducks)
+			: GameStore(0, 0)
+		)
+		, blocks(NULL)
+		, keyframe(NULL)
+		, words(NULL)
+		, ranks(NULL)
+		, entries(NULL)
+		, obvious()
+		, base(0)
+		, slabbed(false)
+		, valid(false)
+	{
+		const MasterHeader *h = masterHeader(*file);
+		if(!h || store.maxBalls() == 0 || maxDucks > store.maxDucks()) {
+			return;
+		}
+		const std::size_t offsetsEnd = sizeof(MasterHeader) + h->balls * sizeof(std::uint64_t);
+		if(offsetsEnd > file->size()) {
+			return;
+		}
+		const std::uint64_t *offsets = reinterpret_cast<const std::uint64_t*>(
+			file->data() + sizeof(MasterHeader)
+		);
+		base = offsets[maxBalls - 1];
+		valid = (
+			base >= offsetsEnd && base + store.fileSize() <= file->size() &&
+			file->data()[base] == maxBalls && file->data()[base + 1] == store.maxDucks()
+		);
+	}
+
+	bool is_open(void) const {
+		return valid;
+	}
+
+	// Whether this table has the states of a game with these limits
+	bool answers(int maxBalls, int maxDucks) const {
+		return valid && store.maxBalls() == maxBalls && store.maxDucks() >= maxDucks;
+	}
+
+	int maxBalls(void) const {
+		return store.maxBalls();
+	}
+
+	int maxDucks(void) const {
+		return store.maxDucks();
+	}
+
+	const GameStore &layout(void) const {
+		return store;
+	}
+
+	void advise(int advice) const {
+		file->advise(advice);
+	}
+
+	// Returns {p0, p1} for the state, or NULL if the state is outside this table
+	const unsigned char *entry(const PlayerState &me, const PlayerState &them) const {
+		if(!valid || !store.contains(me) || !store.contains(them)) {
+			return NULL;
+		}
+		if(blocks) {
+			const std::size_t i = store.gameIndex(me, them);
+			return archived(i / ARCHIVE_BLOCK, i % ARCHIVE_BLOCK, true);
+		}
+		if(words) {
+			return sparseEntry(me, them);
+		}
+		if(slabbed) {
+			return file->data() + sizeof(SlabTableHeader) + store.slabIndex(me, them) * 2;
+		}
+		return file->data() + base + store.fileIndex(me, them);
+	}
+};
+
+// The cache of slabs solved on demand
+static const char *LAZY_CACHE = "nashcache";
+
+// A table file compiled into the binary; a build with -DPITN_EMBEDDED takes
+// them from the nashembedded.h written by the embed mode, and they are
+// used for their limits ahead of any files. The list ends with a NULL table
+struct EmbeddedTable {
+	const unsigned char *data;
+	std::size_t size;
+};
+
+#ifdef PITN_EMBEDDED
+#include "nashembedded.h"
+#else
+static const EmbeddedTable EMBEDDED_TABLES[] = {{NULL, 0}};
+#endif
+
+// The first embedded table which answers for these limits, or NULL
+std::unique_ptr<const PolicyTable> embedded_table(int maxBalls, int maxDucks) {
+	for(const EmbeddedTable *e = EMBEDDED_TABLES; e->data; ++ e) {
+		std::unique_ptr<const PolicyTable> t(new PolicyTable(std::make_shared<MappedFile>(e->data, e->size)));
+		if(t->answers(maxBalls, maxDucks)) {
+			return t;
+		}
+	}
+	return std::unique_ptr<const PolicyTable>();
+}
+
+std::unique_ptr<const PolicyTable> open_file(
+	int turn,
+	int meDucks,
+	int themDucks,
+	int maxBalls,
+	const GenerateOptions &options
+) {
+	// (a table for other limits would give the wrong states)
+	const int maxDucks = std::max(meDucks, themDucks);
+	std::unique_ptr<const PolicyTable> t = embedded_table(maxBalls, maxDucks);
+	if(t) {
+		return t;
+	}
+
+	t.reset(new PolicyTable(GameStore::filename(turn)));
+	if(t->answers(maxBalls, maxDucks)) {
+		return t;
+	}
+
+	t.reset(new PolicyTable(
+		std::make_shared<MappedFile>(ArchiveWriter::defaultFilename()), turn
+	));
+	if(t->answers(maxBalls, maxDucks)) {
+		return t;
+	}
+
+	t.reset(new PolicyTable(GameStore::filename(0)));
+	if(t->answers(maxBalls, maxDucks)) {
+		return t;
+	}
+
+	t.reset(new PolicyTable(SLAB_TABLE_FILE));
+	if(t->answers(maxBalls, maxDucks)) {
+		return t;
+	}
+
+	t.reset(new PolicyTable(std::make_shared<MappedFile>(MASTER_FILE), maxBalls, maxDucks));
+	if(t->answers(maxBalls, maxDucks)) {
+		return t;
+	}
+
+	// only the slabs this game can still reach
+	Generator g(maxBalls, maxDucks);
+	g.solveReachable(meDucks, themDucks, LAZY_CACHE, options);
+	t.reset(new PolicyTable(std::make_shared<MappedFile>(&g.table()[0], g.table().size())));
+	return t;
+}
+
+class PolicyTableSet {
+	// (never changed once constructed, so read without the lock)
+	std::vector<std::unique_ptr<const PolicyTable>> embedded;
+	std::vector<std::unique_ptr<const PolicyTable>> turns;
+	// (kept until the end, as other threads can still be using them)
+	std::vector<std::unique_ptr<const PolicyTable>> generated;
+	std::atomic<const PolicyTable*> fallback;
+	std::mutex mutex;
+
+public:
+	PolicyTableSet(void)
+		: embedded()
+		, turns()
+		, generated()
+		, fallback(NULL)
+		, mutex()
+	{
+		for(const EmbeddedTable *e = EMBEDDED_TABLES; e->data; ++ e) {
+			embedded.emplace_back(new PolicyTable(std::make_shared<MappedFile>(e->data, e->size)));
+		}
+	}
+
+	// Maps every nashdata_<turn>.dat in the working directory, and any
+	// turns in nashdata.arc
+	std::size_t mapAll(void) {
+		std::size_t count = 0;
+		DIR *dir = opendir(".");
+		if(!dir) {
+			return count;
+		}
+		while(dirent *ent = readdir(dir)) {
+			int turn;
+			char end;
+			if(std::sscanf(ent->d_name, "nashdata_%d.da%c", &turn, &end) != 2 || end != 't') {
+				continue;
+			}
+			if(turn < 0 || GameStore::filename(turn) != ent->d_name) {
+				continue;
+			}
+			std::unique_ptr<const PolicyTable> t(new PolicyTable(ent->d_name));
+			if(!t->is_open()) {
+				continue;
+			}
+			if(std::size_t(turn) >= turns.size()) {
+				turns.resize(turn + 1);
+			}
+			turns[turn] = std::move(t);
+			++ count;
+		}
+		closedir(dir);
+
+		// turns without their own file come from the archive, if there is one
+		std::shared_ptr<const MappedFile> archive =
+			std::make_shared<MappedFile>(ArchiveWriter::defaultFilename());
+		for(int turn = 0; ; ++ turn) {
+			std::unique_ptr<const PolicyTable> t(new PolicyTable(archive, turn));
+			if(!t->is_open()) {
+				break;
+			}
+			if(std::size_t(turn) >= turns.size()) {
+				turns.resize(turn + 1);
+			}
+			if(!turns[turn]) {
+				turns[turn] = std::move(t);
+				++ count;
+			}
+		}
+
+		if(!turns.empty() && turns[0]) {
+			fallback = turns[0].get();
+		}
+		return count;
+	}
+
+	const PolicyTable *forTurn(int turn, int maxDucks, int maxBalls) {
+		for(const auto &e : embedded) {
+			if(e->answers(maxBalls, maxDucks)) {
+				return e.get();
+			}
+		}
+		if(
+			turn >= 0 && std::size_t(turn) < turns.size() && turns[turn] &&
+			turns[turn]->answers(maxBalls, maxDucks)
+		) {
+			return turns[turn].get();
+		}
+		const PolicyTable *t = fallback;
+		if(t && t->answers(maxBalls, maxDucks)) {
+			return t;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		for(const auto &g : generated) {
+			if(g->answers(maxBalls, maxDucks)) {
+				return g.get();
+			}
+		}
+		// (every slab, as later queries can have any ducks up to these)
+		GenerateOptions options;
+		options.budget = -1;
+		generated.push_back(open_file(0, maxDucks, maxDucks, maxBalls, options));
+		if(!fallback) {
+			fallback = generated.back().get();
+		}
+		return generated.back().get();
+	}
+};
+
+int pickAction(unsigned char p0, unsigned char p1, int v) {
+	// v is uniform in [0, 254]
+	if(v < p0) {
+		return 0;
+	} else if(v < p1) {
+		return 1;
+	} else {
+		return 2;
+	}
+}
+
+int choose(
+	int turn,
+	const PlayerState &me,
+	const PlayerState &them,
+	int maxBalls,
+	const GenerateOptions &options
+) {
+	std::unique_ptr<const PolicyTable> t = open_file(turn, me.ducks, them.ducks, maxBalls, options);
+	const unsigned char *p = t->entry(me, them);
+	if(!p) {
+		return 0;
+	}
+
+	// only 1 random number per execution; no need to seed a PRNG
+	std::random_device rand;
+	return pickAction(p[0], p[1], std::uniform_int_distribution<int>(0, 254)(rand));
+}
+
+class FastRandom {
+	// xorshift64*; only used for sampling mixed strategies, so speed matters
+	// far more than quality
+	std::uint64_t state;
+
+public:
+	explicit FastRandom(std::uint64_t seed) : state(0) {
+		// splitmix64 scramble so that nearby seeds give unrelated sequences
+		seed += 0x9E3779B97F4A7C15ull;
+		seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+		seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+		state = (seed ^ (seed >> 31)) | 1;
+	}
+
+	std::uint64_t next(void) {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1Dull;
+	}
+
+	int below(int n) {
+		return int(((next() >> 32) * std::uint64_t(n)) >> 32);
+	}
+};
+
+class ServerSession {
+	PolicyTableSet &tables;
+	FastRandom random;
+
+	static bool parseInt(const char *&p, const char *end, int &v) {
+		while(p != end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+			++ p;
+		}
+		bool negative = (p != end && *p == '-');
+		if(negative) {
+			++ p;
+		}
+		if(p == end || *p < '0' || *p > '9') {
+			return false;
+		}
+		v = 0;
+		while(p != end && *p >= '0' && *p <= '9') {
+			v = v * 10 + (*p - '0');
+			++ p;
+		}
+		if(negative) {
+			v = -v;
+		}
+		return true;
+	}
+
+public:
+	ServerSession(PolicyTableSet &tables, std::uint64_t seed)
+		: tables(tables)
+		, random(seed)
+	{}
+
+	int answer(const char *begin, const char *end) {
+		// same arguments as the single-turn command line:
+		// turn, meBalls, themBalls, meDucks, themDucks, maxBalls
+		int args[6];
+		for(int i = 0; i < 6; ++ i) {
+			if(!parseInt(begin, end, args[i])) {
+				return -1;
+			}
+		}
+		const PlayerState me(args[1], args[3]);
+		const PlayerState them(args[2], args[4]);
+
+		const PolicyTable *t = tables.forTurn(
+			args[0],
+			std::max(me.ducks, them.ducks),
+			args[5]
+		);
+		const unsigned char *p = t->entry(me, them);
+		if(!p) {
+			return -1;
+		}
+		return pickAction(p[0], p[1], random.below(255));
+	}
+};
+
+bool writeAll(int fd, const char *data, std::size_t size) {
+	while(size > 0) {
+		ssize_t n = write(fd, data, size);
+		if(n < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+void serveStream(int inFd, int outFd, PolicyTableSet &tables, std::uint64_t seed) {
+	ServerSession session(tables, seed);
+	std::vector<char> in(64 * 1024);
+	std::string out;
+	std::size_t have = 0;
+	bool eof = false;
+
+	while(!eof) {
+		ssize_t n = read(inFd, &in[have], in.size() - have);
+		if(n < 0 && errno == EINTR) {
+			continue;
+		}
+		if(n <= 0) {
+			eof = true;
+			if(have == 0) {
+				break;
+			}
+			in[have ++] = '\n'; // answer a final unterminated line
+		} else {
+			have += n;
+		}
+
+		// answer every complete line from this read in one write
+		std::size_t start = 0;
+		for(std::size_t i = 0; i < have; ++ i) {
+			if(in[i] == '\n') {
+				int action = session.answer(&in[start], &in[i]);
+				if(action < 0) {
+					std::cerr << "Invalid query: " << std::string(&in[start], &in[i]) << std::endl;
+					action = 0;
+				}
+				out += char('0' + action);
+				out += '\n';
+				start = i + 1;
+			}
+		}
+		if(!out.empty()) {
+			if(!writeAll(outFd, out.data(), out.size())) {
+				break;
+			}
+			out.clear();
+		}
+
+		have -= start;
+		std::memmove(&in[0], &in[start], have);
+		if(have == in.size()) {
+			in.resize(in.size() * 2);
+		}
+	}
+}
+
+int serveSocket(const std::string &path, PolicyTableSet &tables, std::uint64_t seed, bool seeded) {
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << "Socket path too long: " << path << std::endl;
+		return 1;
+	}
+	std::strcpy(addr.sun_path, path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0) {
+		std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+	unlink(path.c_str());
+	if(
+		bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+		listen(fd, SOMAXCONN) != 0
+	) {
+		std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+		close(fd);
+		return 1;
+	}
+
+	// clients disconnecting mid-reply should not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	std::random_device rand;
+	for(std::uint64_t connection = 0; ; ++ connection) {
+		int c = accept(fd, NULL, NULL);
+		if(c < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			std::cerr << "Failed to accept: " << std::strerror(errno) << std::endl;
+			break;
+		}
+		std::uint64_t sessionSeed = seeded
+			? seed + connection
+			: (std::uint64_t(rand()) << 32) ^ rand();
+		std::thread([&tables, c, sessionSeed] () {
+			serveStream(c, c, tables, sessionSeed);
+			close(c);
+		}).detach();
+	}
+	close(fd);
+	return 1;
+}
+
+int serve(int argc, const char *const *argv) {
+	std::string socketPath;
+	std::uint64_t seed = 0;
+	bool seeded = false;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg.compare(0, 9, "--socket=") == 0) {
+			socketPath = arg.substr(9);
+		} else if(arg.compare(0, 7, "--seed=") == 0) {
+			seed = std::strtoull(arg.c_str() + 7, NULL, 10);
+			seeded = true;
+		} else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
+	}
+
+	PolicyTableSet tables;
+	std::size_t mapped = tables.mapAll();
+	std::cerr << "Mapped " << mapped << " data file(s)" << std::endl;
+	if(!socketPath.empty()) {
+		return serveSocket(socketPath, tables, seed, seeded);
+	}
+	if(!seeded) {
+		std::random_device rand;
+		seed = (std::uint64_t(rand()) << 32) ^ rand();
+	}
+	serveStream(STDIN_FILENO, STDOUT_FILENO, tables, seed);
+	return 0;
+}
+
+class Agent {
+public:
+	virtual ~Agent(void) {}
+
+	virtual int act(
+		int turn,
+		const PlayerState &me,
+		const PlayerState &them,
+		int maxBalls,
+		FastRandom &random
+	) = 0;
+
+	// Fills in the probability of each action (as for act()), if the agent
+	// can say without being run
+	virtual bool policy(
+		int turn,
+		const PlayerState &me,
+		const PlayerState &them,
+		int maxBalls,
+		std::array<double, 3> &p
+	) const {
+		(void) turn;
+		(void) me;
+		(void) them;
+		(void) maxBalls;
+		(void) p;
+		return false;
+	}
+
+	// True once an external agent has stopped answering properly (which it
+	// reports itself); the game it was playing can't be counted
+	virtual bool failed(void) const {
+		return false;
+	}
+};
+
+// The probabilities of a table entry's actions (see pickAction)
+void entryPolicy(const unsigned char *e, std::array<double, 3> &p) {
+	p[0] = e[0] / 255.0;
+	p[1] = std::max(int(e[1]) - int(e[0]), 0) / 255.0;
+	p[2] = 1 - p[0] - p[1];
+}
+
+class NashAgent : public Agent {
+	PolicyTableSet &tables;
+
+public:
+	explicit NashAgent(PolicyTableSet &tables) : tables(tables) {}
+
+	int act(int turn, const PlayerState &me, const PlayerState &them, int maxBalls, FastRandom &random) {
+		const PolicyTable *t = tables.forTurn(turn, std::max(me.ducks, them.ducks), maxBalls);
+		const unsigned char *p = t->entry(me, them);
+		if(!p) {
+			return RELOAD;
+		}
+		return pickAction(p[0], p[1], random.below(255));
+	}
+
+	bool policy(int turn, const PlayerState &me, const PlayerState &them, int maxBalls, std::array<double, 3> &p) const {
+		const PolicyTable *t = tables.forTurn(turn, std::max(me.ducks, them.ducks), maxBalls);
+		const unsigned char *e = t->entry(me, them);
+		if(!e) {
+			p = std::array<double, 3>{{1, 0, 0}};
+			return true;
+		}
+		entryPolicy(e, p);
+		return true;
+	}
+};
+
+class ArchiveAgent : public Agent {
+	// Plays the tables of an archive other than nashdata.arc turn by turn,
+	// such as the best response saved by exploit
+	std::vector<std::unique_ptr<const PolicyTable>> turns;
+
+	const unsigned char *entry(int turn, const PlayerState &me, const PlayerState &them) const {
+		if(turn < 0 || std::size_t(turn) >= turns.size()) {
+			return NULL;
+		}
+		return turns[turn]->entry(me, them);
+	}
+
+public:
+	explicit ArchiveAgent(const std::string &filename)
+		: turns()
+	{
+		std::shared_ptr<const MappedFile> archive = std::make_shared<MappedFile>(filename);
+		for(int turn = 0; ; ++ turn) {
+			std::unique_ptr<const PolicyTable> t(new PolicyTable(archive, turn));
+			if(!t->is_open()) {
+				break;
+			}
+			turns.push_back(std::move(t));
+		}
+	}
+
+	bool is_open(void) const {
+		return !turns.empty();
+	}
+
+	int act(int turn, const PlayerState &me, const PlayerState &them, int, FastRandom &random) {
+		const unsigned char *p = entry(turn, me, them);
+		if(!p) {
+			return RELOAD;
+		}
+		return pickAction(p[0], p[1], random.below(255));
+	}
+
+	bool policy(int turn, const PlayerState &me, const PlayerState &them, int, std::array<double, 3> &p) const {
+		const unsigned char *e = entry(turn, me, them);
+		if(!e) {
+			p = std::array<double, 3>{{1, 0, 0}};
+			return true;
+		}
+		entryPolicy(e, p);
+		return true;
+	}
+};
+
+class SaveOneAgent : public Agent { // same as save_one.sh
+	static int decide(const PlayerState &me, const PlayerState &them) {
+		if(me.balls > 1) {
+			return THROW;
+		} else if(them.balls == 0) {
+			return (them.ducks == 0) ? THROW : RELOAD;
+		} else if(me.ducks > 1) {
+			return DUCK;
+		} else {
+			return RELOAD;
+		}
+	}
+
+public:
+	int act(int, const PlayerState &me, const PlayerState &them, int, FastRandom &) {
+		return decide(me, them);
+	}
+
+	bool policy(int, const PlayerState &me, const PlayerState &them, int, std::array<double, 3> &p) const {
+		p = std::array<double, 3>();
+		p[decide(me, them)] = 1;
+		return true;
+	}
+};
+
+class SimpleAgent : public Agent { // same as simple.sh
+public:
+	int act(int, const PlayerState &me, const PlayerState &them, int, FastRandom &random) {
+		if(me.balls > them.balls + them.ducks) {
+			return THROW;
+		} else if(me.balls == 0 && them.balls == 0) {
+			return RELOAD;
+		} else {
+			return random.below(3);
+		}
+	}
+
+	bool policy(int, const PlayerState &me, const PlayerState &them, int, std::array<double, 3> &p) const {
+		if(me.balls > them.balls + them.ducks) {
+			p = std::array<double, 3>{{0, 1, 0}};
+		} else if(me.balls == 0 && them.balls == 0) {
+			p = std::array<double, 3>{{1, 0, 0}};
+		} else {
+			p = std::array<double, 3>{{1 / 3.0, 1 / 3.0, 1 / 3.0}};
+		}
+		return true;
+	}
+};
+
+// An agent run as another program, which is given up on (with a message
+// naming it) as soon as it fails to answer with an action
+class ExternalAgent : public Agent {
+	bool broken;
+
+protected:
+	const std::string command;
+
+	explicit ExternalAgent(const std::string &command)
+		: broken(false)
+		, command(command)
+	{}
+
+	int fail(const std::string &reason) {
+		if(!broken) {
+			std::cerr << "Agent \"" << command << "\" " << reason << std::endl;
+			broken = true;
+		}
+		return NOTHING;
+	}
+
+	// Reads one line of the agent's output, which must be an action alone
+	int reply(FILE *out) {
+		char line[32];
+		if(!std::fgets(line, sizeof(line), out)) {
+			return fail("stopped answering");
+		}
+		char *end;
+		const long action = std::strtol(line, &end, 10);
+		if(
+			end == line || action < RELOAD || action > DUCK ||
+			std::strspn(end, " \t\r\n") != std::strlen(end)
+		) {
+			line[std::strcspn(line, "\r\n")] = '\0';
+			return fail("answered \"" + std::string(line) + "\", which isn't an action (0, 1 or 2)");
+		}
+		return int(action);
+	}
+
+public:
+	bool failed(void) const {
+		return broken;
+	}
+};
+
+class PipeAgent : public ExternalAgent {
+	// Runs an external agent once and sends it one query per line, in the
+	// same format as "serve" mode
+	pid_t pid;
+	FILE *in;
+	FILE *out;
+
+public:
+	explicit PipeAgent(const std::string &command)
+		: ExternalAgent(command)
+		, pid(-1)
+		, in(NULL)
+		, out(NULL)
+	{
+		int toChild[2];
+		int fromChild[2];
+		if(pipe(toChild) != 0) {
+			return;
+		}
+		if(pipe(fromChild) != 0) {
+			::close(toChild[0]);
+			::close(toChild[1]);
+			return;
+		}
+		pid = fork();
+		if(pid == 0) {
+			dup2(toChild[0], STDIN_FILENO);
+			dup2(fromChild[1], STDOUT_FILENO);
+			::close(toChild[0]);
+			::close(toChild[1]);
+			::close(fromChild[0]);
+			::close(fromChild[1]);
+			execl("/bin/sh", "sh", "-c", command.c_str(), (char*) NULL);
+			_exit(127);
+		}
+		::close(toChild[0]);
+		::close(fromChild[1]);
+		if(pid < 0) {
+			::close(toChild[1]);
+			::close(fromChild[0]);
+			return;
+		}
+		in = fdopen(toChild[1], "w");
+		out = fdopen(fromChild[0], "r");
+	}
+
+	~PipeAgent(void) {
+		if(in) {
+			std::fclose(in);
+		}
+		if(out) {
+			std::fclose(out);
+		}
+		if(pid > 0) {
+			waitpid(pid, NULL, 0);
+		}
+	}
+
+	int act(int turn, const PlayerState &me, const PlayerState &them, int maxBalls, FastRandom &) {
+		if(failed()) {
+			return NOTHING;
+		}
+		if(!in || !out) {
+			return fail("couldn't be started");
+		}
+		if(
+			std::fprintf(
+				in, "%d %d %d %d %d %d\n",
+				turn, me.balls, them.balls, me.ducks, them.ducks, maxBalls
+			) < 0 ||
+			std::fflush(in) != 0
+		) {
+			return fail("stopped reading queries (an agent which takes the state as arguments needs argv:)");
+		}
+		return reply(out);
+	}
+};
+
+class ArgvAgent : public ExternalAgent {
+	// Runs an external agent afresh for every turn, with the state as its
+	// arguments, as manager.sh does
+public:
+	explicit ArgvAgent(const std::string &command)
+		: ExternalAgent(command)
+	{}
+
+	int act(int turn, const PlayerState &me, const PlayerState &them, int maxBalls, FastRandom &) {
+		if(failed()) {
+			return NOTHING;
+		}
+		std::ostringstream call;
+		call
+			<< command << ' ' << turn << ' ' << me.balls << ' ' << them.balls << ' '
+			<< me.ducks << ' ' << them.ducks << ' ' << maxBalls;
+		FILE *out = popen(call.str().c_str(), "r");
+		if(!out) {
+			return fail("couldn't be started");
+		}
+		const int action = reply(out);
+		pclose(out);
+		return action;
+	}
+};
+
+std::unique_ptr<Agent> makeAgent(const std::string &name, PolicyTableSet &tables) {
+	if(name == "nash") {
+		return std::unique_ptr<Agent>(new NashAgent(tables));
+	} else if(name == "save_one") {
+		return std::unique_ptr<Agent>(new SaveOneAgent());
+	} else if(name == "simple") {
+		return std::unique_ptr<Agent>(new SimpleAgent());
+	} else if(name.compare(0, 5, "argv:") == 0) {
+		return std::unique_ptr<Agent>(new ArgvAgent(name.substr(5)));
+	} else {
+		return std::unique_ptr<Agent>(new PipeAgent(name));
+	}
+}
+
+struct MatchRules {
+	int maxBalls;
+	int initialDucks;
+	int maxTurns;
+
+	MatchRules(void) : maxBalls(50), initialDucks(25), maxTurns(1000) {}
+};
+
+std::uint64_t gameSeed(std::uint64_t seed, long game) {
+	// keep runs with nearby seeds from replaying each other's games
+	return seed * 0x9E3779B97F4A7C15ull + std::uint64_t(game);
+}
+
+static const int GAME_ABANDONED = 2;
+
+// Returns 1 if A won, -1 if B won, 0 for a draw, or GAME_ABANDONED if an
+// agent failed
+int playGame(Agent &a, Agent &b, const MatchRules &rules, FastRandom &random, std::uint64_t &turns) {
+	PlayerState stateA(0, rules.initialDucks);
+	PlayerState stateB(0, rules.initialDucks);
+	for(int turn = 0; turn < rules.maxTurns; ++ turn) {
+		int actA = a.act(turn, stateA, stateB, rules.maxBalls, random);
+		int actB = b.act(turn, stateB, stateA, rules.maxBalls, random);
+		if(a.failed() || b.failed()) {
+			return GAME_ABANDONED;
+		}
+		++ turns;
+		int winner = resolveTurn(stateA, stateB, actA, actB, rules.maxBalls);
+		if(winner != 0) {
+			return winner;
+		}
+	}
+	return 0;
+}
+
+int referee(int argc, const char *const *argv) {
+	std::vector<std::string> agents;
+	long games = -1;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::uint64_t seed = 0;
+	bool verbose = false;
+	MatchRules rules;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg.compare(0, 10, "--threads=") == 0) {
+			threads = std::max(1, std::atoi(arg.c_str() + 10));
+		} else if(arg.compare(0, 7, "--seed=") == 0) {
+			seed = std::strtoull(arg.c_str() + 7, NULL, 10);
+		} else if(arg.compare(0, 8, "--balls=") == 0) {
+			rules.maxBalls = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--ducks=") == 0) {
+			rules.initialDucks = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--turns=") == 0) {
+			rules.maxTurns = std::atoi(arg.c_str() + 8);
+		} else if(arg == "--verbose") {
+			verbose = true;
+		} else if(agents.size() < 2) {
+			agents.push_back(arg);
+		} else if(games < 0) {
+			games = std::atol(arg.c_str());
+		} else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
+	}
+	if(games < 0) {
+		std::cerr << "Usage: referee <agent_1> <agent_2> <total_games> [options]" << std::endl;
+		return 1;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	PolicyTableSet tables;
+	tables.mapAll();
+
+	std::atomic<long> nextGame(0);
+	std::atomic<long> winsA(0);
+	std::atomic<long> winsB(0);
+	std::atomic<long> draws(0);
+	std::atomic<std::uint64_t> totalTurns(0);
+	std::atomic<bool> abandoned(false);
+	std::mutex outputMutex;
+
+	auto worker = [&] () {
+		// external agents are started once per worker and kept running
+		std::unique_ptr<Agent> a = makeAgent(agents[0], tables);
+		std::unique_ptr<Agent> b = makeAgent(agents[1], tables);
+		std::uint64_t turns = 0;
+		for(long game; !abandoned && (game = nextGame ++) < games;) {
+			FastRandom random(gameSeed(seed, game));
+			int winner = playGame(*a, *b, rules, random, turns);
+			if(winner == GAME_ABANDONED) {
+				abandoned = true;
+				break;
+			} else if(winner > 0) {
+				++ winsA;
+			} else if(winner < 0) {
+				++ winsB;
+			} else {
+				++ draws;
+			}
+			if(verbose) {
+				std::lock_guard<std::mutex> lock(outputMutex);
+				std::cout
+					<< "Game " << game << "/" << games << ": "
+					<< (winner > 0 ? "A" : winner < 0 ? "B" : "DRAW") << std::endl;
+			}
+		}
+		totalTurns += turns;
+	};
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for(unsigned i = 1; i < threads; ++ i) {
+		pool.push_back(std::thread(worker));
+	}
+	worker();
+	for(auto &t : pool) {
+		t.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	std::cerr
+		<< "Played " << totalTurns << " turns in " << seconds << "s ("
+		<< (totalTurns / std::max(seconds, 1e-9)) << " turns/s)" << std::endl;
+	if(abandoned) {
+		std::cerr << "Match abandoned" << std::endl;
+		return 1;
+	}
+
+	std::cout << std::endl;
+	std::cout << "Summary: A: " << winsA << "  B: " << winsB << "  DRAW: " << draws << std::endl;
+	return 0;
+}
+
+// One pairing of a tournament. Each is decided by two sequential probability
+// ratio tests on its decisive games, of "a wins 0.5 + delta of them" and of
+// "b wins 0.5 + delta of them", each against "they win half each"; it stops
+// as soon as one is accepted, or both are rejected (they are even)
+struct Pairing {
+	int a;
+	int b;
+	long scheduled;
+	long played;
+	long winsA;
+	long winsB;
+	long draws;
+	int decision; // 1 if a is better, -1 if b is, 2 if even, 0 while undecided
+
+	Pairing(int a, int b)
+		: a(a)
+		, b(b)
+		, scheduled(0)
+		, played(0)
+		, winsA(0)
+		, winsB(0)
+		, draws(0)
+		, decision(0)
+	{}
+
+	void update(double delta, double alpha, double beta) {
+		const double better = std::log((0.5 + delta) / 0.5);
+		const double worse = std::log((0.5 - delta) / 0.5);
+		const double llrA = winsA * better + winsB * worse;
+		const double llrB = winsA * worse + winsB * better;
+		const double accept = std::log((1 - beta) / alpha);
+		const double reject = std::log(beta / (1 - alpha));
+		if(llrA >= accept) {
+			decision = 1;
+		} else if(llrB >= accept) {
+			decision = -1;
+		} else if(llrA <= reject && llrB <= reject) {
+			decision = 2;
+		}
+	}
+};
+
+// Returns the 95% confidence interval half-width of a rate over n games
+double rateInterval(double rate, long n) {
+	return (n > 0) ? 1.96 * std::sqrt(rate * (1 - rate) / n) : 1;
+}
+
+int tournament(int argc, const char *const *argv) {
+	std::vector<std::string> agents;
+	long games = 100000;
+	long batch = 100;
+	double delta = 0.01;
+	double alpha = 0.05;
+	double beta = 0.05;
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::uint64_t seed = 0;
+	bool verbose = false;
+	MatchRules rules;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg.compare(0, 8, "--games=") == 0) {
+			games = std::atol(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--batch=") == 0) {
+			batch = std::max(1L, std::atol(arg.c_str() + 8));
+		} else if(arg.compare(0, 8, "--delta=") == 0) {
+			delta = std::atof(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--alpha=") == 0) {
+			alpha = std::atof(arg.c_str() + 8);
+		} else if(arg.compare(0, 7, "--beta=") == 0) {
+			beta = std::atof(arg.c_str() + 7);
+		} else if(arg.compare(0, 10, "--threads=") == 0) {
+			threads = std::max(1, std::atoi(arg.c_str() + 10));
+		} else if(arg.compare(0, 7, "--seed=") == 0) {
+			seed = std::strtoull(arg.c_str() + 7, NULL, 10);
+		} else if(arg.compare(0, 8, "--balls=") == 0) {
+			rules.maxBalls = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--ducks=") == 0) {
+			rules.initialDucks = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--turns=") == 0) {
+			rules.maxTurns = std::atoi(arg.c_str() + 8);
+		} else if(arg == "--verbose") {
+			verbose = true;
+		} else if(arg.compare(0, 2, "--") == 0) {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
 		} else {
-			return nash(make_game(me, them), verbose);
+			agents.push_back(arg);
 		}
 	}
+	if(agents.size() < 2 || delta <= 0 || delta >= 0.5) {
+		std::cerr << "Usage: tournament <agent_1> <agent_2> [<agent_3>...] [options]" << std::endl;
+		return 1;
+	}
 
-	void generate(int turns, bool saveAll, bool verbose) {
-		next.clear();
-		next.resize(gameStates);
-		std::vector<Value> current(gameStates);
-		std::vector<char> data(2 + gameStates * 2);
+	signal(SIGPIPE, SIG_IGN);
+	PolicyTableSet tables;
+	tables.mapAll();
 
-		for(std::size_t turn = turns; (turn --) > 0;) {
-			if(verbose) {
-				std::cerr << "Generating for turn " << turn << "..." << std::endl;
-			}
-			NumT maxDiff = 0;
-			NumT msd = 0;
-			data[0] = balls;
-			data[1] = ducks;
-			#pragma omp parallel for reduction(+:msd), reduction(max:maxDiff)
-			for(std::size_t meBalls = 0; meBalls < balls + 1; ++ meBalls) {
-				for(std::size_t meDucks = 0; meDucks < ducks + 1; ++ meDucks) {
-					const PlayerState me(meBalls, meDucks);
-					for(std::size_t themBalls = 0; themBalls < balls + 1; ++ themBalls) {
-						for(std::size_t themDucks = 0; themDucks < ducks + 1; ++ themDucks) {
-							const PlayerState them(themBalls, themDucks);
-							const std::size_t p1 = gameIndex(me, them);
-
-							Strategy s = solve(me, them, verbose);
-
-							NumT diff;
-
-							data[2+p1*2  ] = toDat(s.probMe[0]);
-							data[2+p1*2+1] = toDat(s.probMe[0] + s.probMe[1]);
-							current[p1] = s.expectedValue;
-							diff = current[p1].me - next[p1].me;
-							msd += diff * diff;
-							maxDiff = std::max(maxDiff, std::abs(diff));
-						}
+	std::vector<Pairing> pairings;
+	for(int a = 0; a < int(agents.size()); ++ a) {
+		for(int b = a + 1; b < int(agents.size()); ++ b) {
+			pairings.push_back(Pairing(a, b));
+		}
+	}
+	long scheduled = 0;
+	std::atomic<std::uint64_t> totalTurns(0);
+	bool abandoned = false;
+	std::mutex mutex;
+
+	auto worker = [&] () {
+		// external agents are started once per worker and kept running
+		std::vector<std::unique_ptr<Agent>> players;
+		for(const std::string &name : agents) {
+			players.push_back(makeAgent(name, tables));
+		}
+		std::uint64_t turns = 0;
+		while(true) {
+			// the undecided pairing with the fewest games gets the next batch
+			std::size_t p = pairings.size();
+			long first = 0;
+			long count = 0;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for(std::size_t i = 0; i < pairings.size(); ++ i) {
+					if(
+						pairings[i].decision == 0 &&
+						(p == pairings.size() || pairings[i].scheduled < pairings[p].scheduled)
+					) {
+						p = i;
 					}
 				}
+				if(abandoned || p == pairings.size() || scheduled >= games) {
+					break;
+				}
+				first = pairings[p].scheduled;
+				count = std::min(batch, games - scheduled);
+				pairings[p].scheduled += count;
+				scheduled += count;
 			}
 
-			if(saveAll) {
-				std::ofstream fs(filename(turn).c_str(), std::ios_base::binary);
-				fs.write(&data[0], data.size());
-				fs.close();
+			Pairing result(pairings[p].a, pairings[p].b);
+			for(long game = first; game < first + count; ++ game) {
+				FastRandom random(gameSeed(seed, (long(p) << 32) + game));
+				int winner = playGame(*players[result.a], *players[result.b], rules, random, turns);
+				if(winner == GAME_ABANDONED) {
+					break;
+				} else if(winner > 0) {
+					++ result.winsA;
+				} else if(winner < 0) {
+					++ result.winsB;
+				} else {
+					++ result.draws;
+				}
 			}
 
-			if(verbose) {
-				std::cerr
-					<< "Expectations changed by at most " << maxDiff
-					<< " (RMSD: " << std::sqrt(msd / gameStates) << ")" << std::endl;
+			std::lock_guard<std::mutex> lock(mutex);
+			if(players[result.a]->failed() || players[result.b]->failed()) {
+				abandoned = true;
+				break;
 			}
-			if(maxDiff < 0.0001f) {
-				if(verbose) {
-					std::cerr << "Expectations have converged. Stopping." << std::endl;
+			Pairing &pairing = pairings[p];
+			pairing.played += count;
+			pairing.winsA += result.winsA;
+			pairing.winsB += result.winsB;
+			pairing.draws += result.draws;
+			if(pairing.decision == 0) {
+				pairing.update(delta, alpha, beta);
+				if(pairing.decision != 0 && verbose) {
+					std::cerr
+						<< agents[pairing.a] << " vs " << agents[pairing.b] << " decided after "
+						<< pairing.played << " games" << std::endl;
 				}
-				break;
 			}
-			std::swap(next, current);
 		}
+		totalTurns += turns;
+	};
 
-		// Always save turn 0 with the final converged expectations
-		std::ofstream fs(filename(0).c_str(), std::ios_base::binary);
-		fs.write(&data[0], data.size());
-		fs.close();
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for(unsigned i = 1; i < threads; ++ i) {
+		pool.push_back(std::thread(worker));
 	}
-};
-
-void test(void) {
-	std::array<NumT, 9> valuesMe;
-	std::array<NumT, 9> valuesThemT;
-	Game<3, 3> g(&valuesMe, &valuesThemT);
-	for(int i = 0; i < 3; ++ i) {
-		g.coordsMe[i] = i;
-		g.coordsThem[i] = i;
+	worker();
+	for(auto &t : pool) {
+		t.join();
 	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
 
-	Game<2, 2> g2(&valuesMe, &valuesThemT);
-	for(int i = 0; i < 2; ++ i) {
-		g2.coordsMe[i] = i;
-		g2.coordsThem[i] = i;
+	std::cerr
+		<< "Played " << scheduled << " games (" << totalTurns << " turns) in " << seconds << "s ("
+		<< (totalTurns / std::max(seconds, 1e-9)) << " turns/s)" << std::endl;
+	if(abandoned) {
+		std::cerr << "Tournament abandoned" << std::endl;
+		return 1;
 	}
 
-	std::cerr << "Testing rock, paper, scissors:" << std::endl;
-	valuesMe[0] = 0; valuesMe[1] =-1; valuesMe[2] = 1;
-	valuesMe[3] = 1; valuesMe[4] = 0; valuesMe[5] =-1;
-	valuesMe[6] =-1; valuesMe[7] = 1; valuesMe[8] = 0;
-
-	valuesThemT[0] = 0; valuesThemT[1] =-1; valuesThemT[2] = 1;
-	valuesThemT[3] = 1; valuesThemT[4] = 0; valuesThemT[5] =-1;
-	valuesThemT[6] =-1; valuesThemT[7] = 1; valuesThemT[8] = 0;
+	std::cout << "Pairings (A's score, with a 95% confidence interval):" << std::endl;
+	// each agent's score, and squared interval, summed over its pairings
+	// (pairings stop after very different numbers of games, so pooling all
+	// the games would mostly measure the longest pairings)
+	std::vector<double> scores(agents.size());
+	std::vector<double> variances(agents.size());
+	std::vector<int> opponents(agents.size());
+	std::vector<long> played(agents.size());
+	for(const Pairing &pairing : pairings) {
+		const double score = pairing.played ? (pairing.winsA + 0.5 * pairing.draws) / pairing.played : 0.5;
+		std::cout
+			<< "  " << agents[pairing.a] << " vs " << agents[pairing.b] << ": "
+			<< pairing.winsA << "-" << pairing.winsB << "-" << pairing.draws
+			<< " in " << pairing.played << " games, score " << score
+			<< " +/- " << rateInterval(score, pairing.played) << ", "
+			<< (
+				pairing.decision == 1 ? agents[pairing.a] + " is better" :
+				pairing.decision == -1 ? agents[pairing.b] + " is better" :
+				pairing.decision == 2 ? std::string("even") :
+				std::string("undecided")
+			) << std::endl;
+		if(pairing.played == 0) {
+			continue;
+		}
+		const double interval = rateInterval(score, pairing.played);
+		scores[pairing.a] += score;
+		scores[pairing.b] += 1 - score;
+		for(int i : {pairing.a, pairing.b}) {
+			variances[i] += interval * interval;
+			++ opponents[i];
+			played[i] += pairing.played;
+		}
+	}
 
-	debugGame(g);
-	debugStrategy(nash(g, true));
+	std::vector<std::size_t> ranking(agents.size());
+	for(std::size_t i = 0; i < ranking.size(); ++ i) {
+		ranking[i] = i;
+	}
+	auto score = [&] (std::size_t i) { return opponents[i] ? scores[i] / opponents[i] : 0.5; };
+	std::stable_sort(ranking.begin(), ranking.end(), [&] (std::size_t x, std::size_t y) {
+		return score(x) > score(y);
+	});
+	std::cout << "Ranking (mean score over its pairings):" << std::endl;
+	for(std::size_t r = 0; r < ranking.size(); ++ r) {
+		const std::size_t i = ranking[r];
+		std::cout
+			<< "  " << (r + 1) << ". " << agents[i] << ": " << score(i)
+			<< " +/- " << (opponents[i] ? std::sqrt(variances[i]) / opponents[i] : 1)
+			<< " (" << opponents[i] << " pairings, " << played[i] << " games)" << std::endl;
+	}
+	return 0;
+}
 
-	std::cerr << "Testing chicken (L, C, R):" << std::endl;
-	valuesMe[0] = 0; valuesMe[1] =-1; valuesMe[2] =-10;
-	valuesMe[3] = 1; valuesMe[4] =-10; valuesMe[5] = 1;
-	valuesMe[6] =-10; valuesMe[7] =-1; valuesMe[8] = 0;
+// Works out the exact chance of each result of a game between two built-in
+// agents, by pushing the probability of being in each state forward a turn
+// at a time with both agents' action probabilities, until the chance that
+// the game is still going is below epsilon (which is then counted as a
+// draw). Threads each add into their own copy of the next turn's
+// probabilities, which are then summed, so results don't depend on timing
+struct Odds {
+	double winsA;
+	double winsB;
+	double draws;
+	double turns; // expected length of a game
+	int lastTurn; // the turn it stopped after
+};
 
-	valuesThemT[0] = 0; valuesThemT[1] =-1; valuesThemT[2] =-10;
-	valuesThemT[3] = 1; valuesThemT[4] =-10; valuesThemT[5] = 1;
-	valuesThemT[6] =-10; valuesThemT[7] =-1; valuesThemT[8] = 0;
+Odds forwardOdds(const Agent &a, const Agent &b, const MatchRules &rules, double epsilon) {
+	const GameStore store(rules.maxBalls, rules.initialDucks);
+	const std::size_t states = store.fileSize() / 2 - 1;
+	int threads = 1;
+#ifdef _OPENMP
+	threads = omp_get_max_threads();
+#endif
+	// (buffers[0] is the next turn itself)
+	std::vector<std::vector<double>> buffers(threads);
+	for(auto &buffer : buffers) {
+		buffer.assign(states, 0);
+	}
+	std::vector<double> current(states);
+	const PlayerState start(0, rules.initialDucks);
+	std::size_t lo = store.gameIndex(start, start);
+	std::size_t hi = lo + 1;
+	current[lo] = 1;
 
-	debugGame(g);
-	debugStrategy(nash(g, true));
+	Odds odds = Odds();
+	double playing = 1;
+	int turn = 0;
+	for(; turn < rules.maxTurns && playing >= epsilon; ++ turn) {
+		odds.turns += playing;
+		double winsA = 0;
+		double winsB = 0;
+		std::size_t nextLo = states;
+		std::size_t nextHi = 0;
+		#pragma omp parallel reduction(+:winsA, winsB)
+		{
+			int thread = 0;
+#ifdef _OPENMP
+			thread = omp_get_thread_num();
+#endif
+			std::vector<double> &next = buffers[thread];
+			std::size_t threadLo = states;
+			std::size_t threadHi = 0;
+			std::array<double, 3> pa;
+			std::array<double, 3> pb;
+			#pragma omp for schedule(static)
+			for(std::size_t i = lo; i < hi; ++ i) {
+				const double p = current[i];
+				if(p == 0) {
+					continue;
+				}
+				const auto state = store.stateFromGameIndex(i);
+				a.policy(turn, state.first, state.second, rules.maxBalls, pa);
+				b.policy(turn, state.second, state.first, rules.maxBalls, pb);
+				for(int x = 0; x < 3; ++ x) {
+					for(int y = 0; y < 3; ++ y) {
+						const double q = p * pa[x] * pb[y];
+						if(q == 0) {
+							continue;
+						}
+						PlayerState stateA = state.first;
+						PlayerState stateB = state.second;
+						const int winner = resolveTurn(stateA, stateB, x, y, rules.maxBalls);
+						if(winner > 0) {
+							winsA += q;
+						} else if(winner < 0) {
+							winsB += q;
+						} else {
+							const std::size_t j = store.gameIndex(stateA, stateB);
+							next[j] += q;
+							threadLo = std::min(threadLo, j);
+							threadHi = std::max(threadHi, j + 1);
+						}
+					}
+				}
+			}
+			#pragma omp critical
+			{
+				nextLo = std::min(nextLo, threadLo);
+				nextHi = std::max(nextHi, threadHi);
+			}
+		}
+		odds.winsA += winsA;
+		odds.winsB += winsB;
 
-	std::cerr << "Testing chicken (L, C):" << std::endl;
-	debugGame(g2);
-	debugStrategy(nash(g2, true));
+		std::fill(current.begin() + lo, current.begin() + hi, 0);
+		std::swap(current, buffers[0]);
+		lo = std::min(nextLo, nextHi);
+		hi = nextHi;
+		playing = 0;
+		#pragma omp parallel for schedule(static) reduction(+:playing)
+		for(std::size_t j = lo; j < hi; ++ j) {
+			for(int t = 1; t < threads; ++ t) {
+				current[j] += buffers[t][j];
+				buffers[t][j] = 0;
+			}
+			playing += current[j];
+		}
+	}
+	odds.draws = playing;
+	odds.lastTurn = turn;
+	return odds;
+}
 
-	std::cerr << "Testing online example:" << std::endl;
-	valuesMe[0] = 1; valuesMe[1] = 10; valuesMe[2] =-10;
-	valuesMe[3] = 0; valuesMe[4] = 1; valuesMe[5] = 10;
-	valuesMe[6] = 1; valuesMe[7] = 1; valuesMe[8] = 1;
+int odds(int argc, const char *const *argv) {
+	std::vector<std::string> agents;
+	MatchRules rules;
+	double epsilon = 1e-12;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg.compare(0, 8, "--balls=") == 0) {
+			rules.maxBalls = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--ducks=") == 0) {
+			rules.initialDucks = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--turns=") == 0) {
+			rules.maxTurns = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 10, "--epsilon=") == 0) {
+			epsilon = std::atof(arg.c_str() + 10);
+		} else if(agents.size() < 2 && arg.compare(0, 2, "--") != 0) {
+			agents.push_back(arg);
+		} else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
+	}
+	if(agents.size() < 2) {
+		std::cerr << "Usage: odds <agent_1> <agent_2> [options]" << std::endl;
+		return 1;
+	}
 
-	valuesThemT[0] = 1; valuesThemT[1] = 10; valuesThemT[2] =-10;
-	valuesThemT[3] = 0; valuesThemT[4] = 1; valuesThemT[5] = 10;
-	valuesThemT[6] = 1; valuesThemT[7] = 1; valuesThemT[8] = 1;
+	PolicyTableSet tables;
+	tables.mapAll();
+	std::unique_ptr<Agent> a = makeAgent(agents[0], tables);
+	std::unique_ptr<Agent> b = makeAgent(agents[1], tables);
+	std::array<double, 3> p;
+	if(
+		!a->policy(0, PlayerState(0, 0), PlayerState(0, 0), rules.maxBalls, p) ||
+		!b->policy(0, PlayerState(0, 0), PlayerState(0, 0), rules.maxBalls, p)
+	) {
+		std::cerr << "Only built-in agents can be evaluated" << std::endl;
+		return 1;
+	}
 
-	debugGame(g);
-	debugStrategy(nash(g, true));
+	auto begin = std::chrono::steady_clock::now();
+	const Odds result = forwardOdds(*a, *b, rules, epsilon);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	std::cerr
+		<< "Worked through " << result.lastTurn << " turns in " << seconds << "s (games last "
+		<< result.turns << " turns on average)" << std::endl;
+	std::cout
+		<< "A: " << result.winsA << "  B: " << result.winsB << "  DRAW: " << result.draws << std::endl;
+	return 0;
+}
 
-	std::cerr << "Testing online example 2 (clear pure strategy):" << std::endl;
-	valuesMe[0] = 3; valuesMe[1] = 3; valuesMe[2] = 2;
-	valuesMe[3] = 1; valuesMe[4] = 3; valuesMe[5] = 0;
-	valuesMe[6] = 0; valuesMe[7] = 0; valuesMe[8] = 3;
+static const char *RESPONSE_FILE = "nashresponse.arc";
 
-	valuesThemT[0] = 2; valuesThemT[1] = 0; valuesThemT[2] = 2;
-	valuesThemT[3] = 0; valuesThemT[4] = 3; valuesThemT[5] = 0;
-	valuesThemT[6] = 2; valuesThemT[7] = 3; valuesThemT[8] = 2;
+int exploit(int argc, const char *const *argv) {
+	std::string name;
+	MatchRules rules;
+	bool verbose = false;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg.compare(0, 8, "--balls=") == 0) {
+			rules.maxBalls = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--ducks=") == 0) {
+			rules.initialDucks = std::atoi(arg.c_str() + 8);
+		} else if(arg.compare(0, 8, "--turns=") == 0) {
+			rules.maxTurns = std::atoi(arg.c_str() + 8);
+		} else if(arg == "--verbose") {
+			verbose = true;
+		} else if(name.empty() && arg.compare(0, 2, "--") != 0) {
+			name = arg;
+		} else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
+	}
+	if(name.empty()) {
+		std::cerr << "Usage: exploit <agent> [options]" << std::endl;
+		return 1;
+	}
 
-	debugGame(g);
-	debugStrategy(nash(g, true));
+	PolicyTableSet tables;
+	tables.mapAll();
+	std::unique_ptr<Agent> agent = makeAgent(name, tables);
+	std::array<double, 3> p;
+	if(!agent->policy(0, PlayerState(0, 0), PlayerState(0, 0), rules.maxBalls, p)) {
+		std::cerr << "Only built-in agents can be evaluated" << std::endl;
+		return 1;
+	}
 
-	std::cerr << "Testing online example 3 (mixed > pure):" << std::endl;
-	valuesMe[0] = 1; valuesMe[1] = 0; valuesMe[2] = 0;
-	valuesMe[3] = 0; valuesMe[4] = 0; valuesMe[5] = 3;
-	valuesMe[6] = 0; valuesMe[7] = 2; valuesMe[8] = 0;
+	auto begin = std::chrono::steady_clock::now();
+	Generator g(rules.maxBalls, rules.initialDucks);
+	{
+		ArchiveWriter archive(g, RESPONSE_FILE);
+		g.bestResponse(rules.maxTurns, [&agent, &rules] (int turn, const PlayerState &me, const PlayerState &them) {
+			std::array<double, 3> p;
+			agent->policy(turn, me, them, rules.maxBalls, p);
+			return p;
+		}, archive, verbose);
+		archive.finish();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	std::cerr << "Solved the best response in " << seconds << "s" << std::endl;
 
-	valuesThemT[0] = 1; valuesThemT[1] = 0; valuesThemT[2] = 0;
-	valuesThemT[3] = 0; valuesThemT[4] = 2; valuesThemT[5] = 0;
-	valuesThemT[6] = 0; valuesThemT[7] = 0; valuesThemT[8] = 3;
+	const PlayerState start(0, rules.initialDucks);
+	const NumT value = g.nextGame(start, start).me;
+	std::cout
+		<< name << " scores " << value << " (wins minus losses, per game) against a best response" << std::endl
+		<< "Exploitability: " << (-value) << std::endl;
 
-	debugGame(g);
-	debugStrategy(nash(g, true));
+	// play the saved tables against the agent, to check they hold it to that
+	const ArchiveAgent response(RESPONSE_FILE);
+	if(!response.is_open()) {
+		std::cerr << "Failed to write " << RESPONSE_FILE << std::endl;
+		return 1;
+	}
+	const Odds odds = forwardOdds(*agent, response, rules, 1e-12);
+	const double played = odds.winsA - odds.winsB;
+	if(std::abs(played - value) > 1e-6) {
+		std::cerr
+			<< "The response saved to " << RESPONSE_FILE << " only holds " << name
+			<< " to " << played << std::endl;
+		return 1;
+	}
+	std::cout << "The best response for each turn is saved to " << RESPONSE_FILE << std::endl;
+	return 0;
+}
 
-	std::cerr << "Testing prisoner's dilemma:" << std::endl;
-	valuesMe[0] =-1; valuesMe[1] =-3;
-	valuesMe[3] = 0; valuesMe[4] =-2;
+// One benchmark measurement; samples are nanoseconds per call (or per
+// state), for the percentiles
+struct BenchResult {
+	std::string name;
+	std::string size; // maxBalls/maxDucks, if it applies
+	int threads;
+	std::size_t calls;
+	double seconds;
+	std::vector<double> samples;
 
-	valuesThemT[0] =-1; valuesThemT[1] =-3;
-	valuesThemT[3] = 0; valuesThemT[4] =-2;
+	BenchResult(const std::string &name, const std::string &size, int threads)
+		: name(name)
+		, size(size)
+		, threads(threads)
+		, calls(0)
+		, seconds(0)
+		, samples()
+	{}
 
-	debugGame(g2);
-	debugStrategy(nash(g2, true));
+	double percentile(double p) const {
+		if(samples.empty()) {
+			return 0;
+		}
+		std::vector<double> sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[std::min(sorted.size() - 1, std::size_t(p * sorted.size()))];
+	}
+};
 
-	std::cerr << "Testing problematic grid:" << std::endl;
-	valuesMe[0] =-0.5; valuesMe[1] =-1; valuesMe[2] = 0;
-	valuesMe[3] = 1; valuesMe[4] =-0.5; valuesMe[5] =-0.75;
-	valuesMe[6] =-1; valuesMe[7] =-0.5; valuesMe[8] =-0.75;
+void printBench(const std::vector<BenchResult> &results, bool csv) {
+	if(csv) {
+		std::cout << "benchmark,size,threads,calls,ns_per_call,per_sec,p50_ns,p90_ns,p99_ns" << std::endl;
+	} else {
+		std::cout << "[" << std::endl;
+	}
+	for(std::size_t i = 0; i < results.size(); ++ i) {
+		const BenchResult &r = results[i];
+		const double ns = r.seconds * 1e9 / std::max(r.calls, std::size_t(1));
+		const double perSec = r.calls / std::max(r.seconds, 1e-12);
+		if(csv) {
+			std::cout
+				<< r.name << ',' << r.size << ',' << r.threads << ',' << r.calls
+				<< ',' << ns << ',' << perSec << ',' << r.percentile(0.5)
+				<< ',' << r.percentile(0.9) << ',' << r.percentile(0.99) << std::endl;
+		} else {
+			std::cout
+				<< "  {\"benchmark\": \"" << r.name << "\", \"size\": \"" << r.size
+				<< "\", \"threads\": " << r.threads << ", \"calls\": " << r.calls
+				<< ", \"ns_per_call\": " << ns << ", \"per_sec\": " << perSec
+				<< ", \"p50_ns\": " << r.percentile(0.5)
+				<< ", \"p90_ns\": " << r.percentile(0.9)
+				<< ", \"p99_ns\": " << r.percentile(0.99)
+				<< "}" << ((i + 1 < results.size()) ? "," : "") << std::endl;
+		}
+	}
+	if(!csv) {
+		std::cout << "]" << std::endl;
+	}
+}
 
-	valuesThemT[0] = 0.5; valuesThemT[1] =-1; valuesThemT[2] = 1;
-	valuesThemT[3] = 1; valuesThemT[4] = 0.5; valuesThemT[5] = 0.5;
-	valuesThemT[6] = 0; valuesThemT[7] = 0.75; valuesThemT[8] = 0.75;
+// Times f(i) for i in [0, count) `reps` times over, in batches of BENCH_BATCH
+// calls (timing each call would mostly measure the clock)
+static const std::size_t BENCH_BATCH = 64;
 
-	debugGame(g);
-	debugStrategy(nash(g, true));
+template <typename F>
+void timeCalls(BenchResult &r, std::size_t count, int reps, F f) {
+	for(int rep = 0; rep < reps; ++ rep) {
+		for(std::size_t begin = 0; begin < count; begin += BENCH_BATCH) {
+			const std::size_t end = std::min(begin + BENCH_BATCH, count);
+			auto start = std::chrono::steady_clock::now();
+			for(std::size_t i = begin; i < end; ++ i) {
+				f(i);
+			}
+			const double seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start
+			).count();
+			r.seconds += seconds;
+			r.calls += end - begin;
+			r.samples.push_back(seconds * 1e9 / (end - begin));
+		}
+	}
 }
 
-void open_file(std::ifstream &target, int turn, int maxDucks, int maxBalls) {
-	target.open(GameStore::filename(turn).c_str(), std::ios::binary);
-	if(target.is_open()) {
-		return;
+int bench(int argc, const char *const *argv) {
+	bool csv = false;
+	bool quick = false;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg == "--format=csv") {
+			csv = true;
+		} else if(arg == "--format=json") {
+			csv = false;
+		} else if(arg == "--quick") {
+			quick = true;
+		} else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return 1;
+		}
 	}
 
-	target.open(GameStore::filename(0).c_str(), std::ios::binary);
-	if(target.is_open()) {
-		return;
+	// everything is written to (and removed from) a scratch directory, so
+	// that the tables in the working directory are not touched or used
+	char dir[] = "/tmp/pain_in_the_nash_bench_XXXXXX";
+	if(!mkdtemp(dir) || chdir(dir) != 0) {
+		std::cerr << "Can't create a scratch directory" << std::endl;
+		return 1;
 	}
 
-	Generator(maxBalls, maxDucks).generate(200, false, false);
-	target.open(GameStore::filename(0).c_str(), std::ios::binary);
-}
+	const int sizes[][2] = {{12, 6}, {20, 10}, {30, 15}};
+	const int sizeCount = quick ? 1 : 3;
+	const int maxBalls = sizes[sizeCount - 1][0];
+	const int maxDucks = sizes[sizeCount - 1][1];
+	const std::string size = std::to_string(maxBalls) + "/" + std::to_string(maxDucks);
+	const int reps = quick ? 2 : 10;
+	std::vector<BenchResult> results;
+	volatile NumT sink = 0;
 
-int choose(int turn, const PlayerState &me, const PlayerState &them, int maxBalls) {
-	std::ifstream fs;
-	open_file(fs, turn, std::max(me.ducks, them.ducks), maxBalls);
+	// the solver is timed on the games of a converged table, as those are
+	// the payoffs it actually sees
+	std::cerr << "Solving " << size << " to record its games..." << std::endl;
+	GenerateOptions stationary;
+	stationary.stationary = true;
+	Generator g(maxBalls, maxDucks);
+	g.generate(1000, SAVE_FINAL, false, stationary);
 
-	unsigned char balls = fs.get();
-	unsigned char ducks = fs.get();
-	fs.seekg(GameStore(balls, ducks).fileIndex(me, them));
-	unsigned char p0 = fs.get();
-	unsigned char p1 = fs.get();
-	fs.close();
+	std::vector<std::pair<std::array<NumT, 9>, std::array<NumT, 9>>> games;
+	std::vector<std::pair<PlayerState, PlayerState>> states;
+	for(std::size_t i = 0; i < g.fileSize() / 2 - 1; ++ i) {
+		auto state = g.stateFromGameIndex(i);
+		states.push_back(state);
+		if(obviousCase(state.first, state.second) != NOT_OBVIOUS) {
+			continue;
+		}
+		std::array<NumT, 9> valuesMe;
+		std::array<NumT, 9> valuesThemT;
+		g.make_probabilities(valuesMe, state.first, state.second);
+		g.make_probabilities(valuesThemT, state.second, state.first);
+		games.push_back(std::make_pair(valuesMe, valuesThemT));
+	}
 
-	// only 1 random number per execution; no need to seed a PRNG
-	std::random_device rand;
-	int v = std::uniform_int_distribution<int>(0, 254)(rand);
-	if(v < p0) {
-		return 0;
-	} else if(v < p1) {
-		return 1;
-	} else {
-		return 2;
+	std::cerr << "Timing the solver on " << games.size() << " games..." << std::endl;
+	results.push_back(BenchResult("nash_3x3", size, 1));
+	timeCalls(results.back(), games.size(), reps, [&] (std::size_t i) {
+		Game<3, 3> game(&games[i].first, &games[i].second);
+		for(int k = 0; k < 3; ++ k) {
+			game.coordsMe[k] = k;
+			game.coordsThem[k] = k;
+		}
+		sink = sink + nash(game, false).expectedValue.me;
+	});
+	results.push_back(BenchResult("nash_2x2", size, 1));
+	timeCalls(results.back(), games.size(), reps, [&] (std::size_t i) {
+		// the reload/throw subgame, which every 3x3 solve tries
+		Game<2, 2> game(&games[i].first, &games[i].second);
+		for(int k = 0; k < 2; ++ k) {
+			game.coordsMe[k] = k;
+			game.coordsThem[k] = k;
+		}
+		sink = sink + nash(game, false).expectedValue.me;
+	});
+	results.push_back(BenchResult("solve_state", size, 1));
+	timeCalls(results.back(), states.size(), reps, [&] (std::size_t i) {
+		sink = sink + g.solve(states[i].first, states[i].second, false).expectedValue.me;
+	});
+
+	for(int n = 0; n < sizeCount; ++ n) {
+		const std::string sweepSize = std::to_string(sizes[n][0]) + "/" + std::to_string(sizes[n][1]);
+		std::cerr << "Timing sweeps at " << sweepSize << "..." << std::endl;
+		Generator sweeper(sizes[n][0], sizes[n][1]);
+		const std::size_t stateCount = sweeper.fileSize() / 2 - 1;
+		for(int threads : Generator::threadCounts()) {
+			BenchResult r("sweep", sweepSize, threads);
+			for(double seconds : sweeper.timeSweeps(quick ? 2 : 5, threads, GenerateOptions())) {
+				r.seconds += seconds;
+				r.calls += stateCount;
+				r.samples.push_back(seconds * 1e9 / stateCount);
+			}
+			results.push_back(r);
+		}
+#ifdef _OPENMP
+		omp_set_num_threads(Generator::threadCounts().back());
+#endif
+	}
+
+	// end to end: finding and mapping the table, the lookup and the random
+	// number, as in a single-turn call
+	std::cerr << "Timing choose()..." << std::endl;
+	results.push_back(BenchResult("choose", size, 1));
+	{
+		BenchResult &r = results.back();
+		std::mt19937 rand(1);
+		const GenerateOptions options;
+		for(int i = 0; i < (quick ? 1000 : 10000); ++ i) {
+			const int turn = std::uniform_int_distribution<int>(1, 1000)(rand);
+			const std::pair<PlayerState, PlayerState> &state = states[
+				std::uniform_int_distribution<std::size_t>(0, states.size() - 1)(rand)
+			];
+			auto start = std::chrono::steady_clock::now();
+			sink = sink + choose(turn, state.first, state.second, maxBalls, options);
+			const double seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start
+			).count();
+			r.seconds += seconds;
+			++ r.calls;
+			r.samples.push_back(seconds * 1e9);
+		}
 	}
+
+	std::remove(GameStore::filename(0).c_str());
+	if(chdir("/") == 0) {
+		rmdir(dir);
+	}
+	printBench(results, csv);
+	return 0;
 }
 
 void debugFilePos(std::size_t pos) {
-	std::ifstream fs(GameStore::filename(0).c_str(), std::ios::binary);
-	unsigned char balls = fs.get();
-	unsigned char ducks = fs.get();
+	PolicyTable t(GameStore::filename(0));
+	if(!t.is_open()) {
+		std::cerr << "No valid " << GameStore::filename(0) << std::endl;
+		return;
+	}
 
-	auto state = GameStore(balls, ducks).stateFromFileIndex(pos);
+	auto state = t.layout().stateFromFileIndex(pos);
 	std::cout
 		<< "Me:   balls = " << state.first.balls
 		<< ", ducks = " << state.first.ducks << std::endl
@@ -771,7 +5715,146 @@ void debugFilePos(std::size_t pos) {
 		<< ", ducks = " << state.second.ducks << std::endl;
 }
 
+static const char *EMBEDDED_HEADER = "nashembedded.h";
+
+// Writes the bytes as a string literal, a line of 32 bytes at a time
+// (escaping everything but plain printable characters, and '?' so that no
+// trigraphs turn up)
+void writeLiteral(std::ostream &out, const unsigned char *bytes, std::size_t size) {
+	static const char *const digits = "01234567";
+	for(std::size_t i = 0; i < size; i += 32) {
+		out << "\t\"";
+		for(std::size_t j = i; j < std::min(i + 32, size); ++ j) {
+			const unsigned char c = bytes[j];
+			if(c >= ' ' && c <= '~' && c != '"' && c != '\\' && c != '?') {
+				out << c;
+			} else {
+				out << '\\' << digits[c >> 6] << digits[(c >> 3) & 7] << digits[c & 7];
+			}
+		}
+		out << '"' << std::endl;
+	}
+}
+
+// Generates the converged table for each pair of limits, and writes them all
+// to nashembedded.h for a build with -DPITN_EMBEDDED (see EmbeddedTable)
+int embed(int argc, const char *const *argv) {
+	GenerateOptions options;
+	std::vector<int> numbers;
+	for(int i = 0; i < argc; ++ i) {
+		std::string arg = argv[i];
+		if(arg.compare(0, 2, "--") == 0) {
+			if(!options.parse(arg)) {
+				std::cerr << "Unknown option: " << arg << std::endl;
+				return 1;
+			}
+		} else {
+			numbers.push_back(std::atoi(arg.c_str()));
+		}
+	}
+	if(numbers.size() < 3 || numbers.size() % 2 == 0) {
+		std::cerr
+			<< "Usage: embed <max_turns> <max_balls> <max_ducks> [<max_balls> <max_ducks> ...] [options]"
+			<< std::endl;
+		return 1;
+	}
+	if(
+		options.archive || options.master || options.outOfCore ||
+		options.precision != PRECISION_DOUBLE || options.checkpoint > 0 || options.resume
+	) {
+		std::cerr
+			<< "embed only takes the options for generating a single table in double precision"
+			<< std::endl;
+		return 1;
+	}
+
+	const std::string temp = std::string(EMBEDDED_HEADER) + "." + std::to_string(getpid()) + ".tmp";
+	std::ofstream out(temp.c_str());
+	out << "// Generated by: pain_in_the_nash embed";
+	for(int i = 0; i < argc; ++ i) {
+		out << ' ' << argv[i];
+	}
+	out << std::endl;
+	std::vector<std::size_t> sizes;
+	for(std::size_t i = 1; i < numbers.size(); i += 2) {
+		const int maxBalls = numbers[i];
+		const int maxDucks = numbers[i + 1];
+		auto begin = std::chrono::steady_clock::now();
+		Generator g(maxBalls, maxDucks);
+		g.generate(numbers[0], SAVE_NOTHING, false, options);
+		std::ostringstream table;
+		g.save(table, g.table(), options.sparse);
+		const std::string bytes = table.str();
+		// (aligned like the words and offsets in the table headers)
+		out
+			<< std::endl << "alignas(8) static const unsigned char EMBEDDED_TABLE_" << sizes.size()
+			<< "[] = // " << maxBalls << " balls, " << maxDucks << " ducks" << std::endl;
+		writeLiteral(out, reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+		out << ";" << std::endl;
+		sizes.push_back(bytes.size());
+		std::cerr
+			<< "Embedded " << maxBalls << "/" << maxDucks << " (" << bytes.size() << " bytes) after "
+			<< std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()
+			<< " seconds" << std::endl;
+	}
+	out << std::endl << "static const EmbeddedTable EMBEDDED_TABLES[] = {" << std::endl;
+	for(std::size_t i = 0; i < sizes.size(); ++ i) {
+		out << "\t{EMBEDDED_TABLE_" << i << ", " << sizes[i] << "}," << std::endl;
+	}
+	out << "\t{NULL, 0}" << std::endl << "};" << std::endl;
+	out.close();
+	if(!out || std::rename(temp.c_str(), EMBEDDED_HEADER) != 0) {
+		std::cerr << "Failed to write " << EMBEDDED_HEADER << std::endl;
+		std::remove(temp.c_str());
+		return 1;
+	}
+	return 0;
+}
+
 int main(int argc, const char *const *argv) {
+	if(argc >= 2 && std::string(argv[1]) == "serve") {
+		return serve(argc - 2, argv + 2);
+	}
+
+	if(argc >= 2 && std::string(argv[1]) == "referee") {
+		return referee(argc - 2, argv + 2);
+	}
+
+	if(argc >= 2 && std::string(argv[1]) == "odds") {
+		return odds(argc - 2, argv + 2);
+	}
+
+	if(argc >= 2 && std::string(argv[1]) == "exploit") {
+		return exploit(argc - 2, argv + 2);
+	}
+
+	if(argc >= 2 && std::string(argv[1]) == "tournament") {
+		return tournament(argc - 2, argv + 2);
+	}
+
+	if(argc >= 2 && std::string(argv[1]) == "bench") {
+		return bench(argc - 2, argv + 2);
+	}
+
+	if(argc >= 2 && std::string(argv[1]) == "embed") {
+		return embed(argc - 2, argv + 2);
+	}
+
+	GenerateOptions options;
+	std::vector<const char*> args;
+	for(int i = 0; i < argc; ++ i) {
+		if(i > 0 && argv[i][0] == '-' && argv[i][1] == '-') {
+			if(!options.parse(argv[i])) {
+				std::cerr << "Unknown option: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+	argc = args.size();
+	argv = &args[0];
+
 	if(argc == 1) {
 		test();
 		return 0;
@@ -782,8 +5865,53 @@ int main(int argc, const char *const *argv) {
 		return 0;
 	}
 
+	if(argc == 4 && options.scaling) { // sweeps, maxBalls, maxDucks
+		Generator(atoi(argv[2]), atoi(argv[3])).scalingReport(atoi(argv[1]), options);
+		return 0;
+	}
+
 	if(argc == 4) { // maxTurns, maxBalls, maxDucks
-		Generator(atoi(argv[2]), atoi(argv[3])).generate(atoi(argv[1]), true, true);
+		if(options.precision == PRECISION_MIXED && options.outOfCore) {
+			std::cerr << "--precision=mixed can't be used with --out-of-core" << std::endl;
+			return 1;
+		}
+#ifndef __AVX2__
+		if(options.batched) {
+			// (in 2-wide SSE2 registers it is about as fast as the scalar solver, or slower)
+			std::cerr
+				<< "Note: --batched is only faster when built with wide vector registers (./build.sh --native)"
+				<< std::endl;
+		}
+#endif
+		if(options.supportCache && (options.batched || options.outOfCore)) {
+			// (nash_batch always tries every candidate, and out-of-core
+			// generation doesn't keep a byte per state)
+			std::cerr << "--support-cache can't be used with --batched or --out-of-core" << std::endl;
+			return 1;
+		}
+		if(options.precision == PRECISION_MIXED && options.archive) {
+			// (each precision would write its own archive)
+			std::cerr << "--precision=mixed can't be used with --archive" << std::endl;
+			return 1;
+		}
+		if((options.checkpoint > 0 || options.resume) && (
+			options.archive || options.master ||
+			options.precision == PRECISION_MIXED || options.precisionReport
+		)) {
+			// (the archive is only written at the end, and the others run
+			// several generations)
+			std::cerr
+				<< "--checkpoint and --resume can't be used with --archive, --master, "
+				<< "--precision=mixed or --precision-report" << std::endl;
+			return 1;
+		}
+		if(options.outOfCore) {
+			generateOutOfCore(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), options);
+		} else if(options.master) {
+			generateMaster(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), options);
+		} else {
+			generateTables(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), options);
+		}
 		return 0;
 	}
 
@@ -792,7 +5920,8 @@ int main(int argc, const char *const *argv) {
 			atoi(argv[1]),
 			PlayerState(atoi(argv[2]), atoi(argv[4])),
 			PlayerState(atoi(argv[3]), atoi(argv[5])),
-			atoi(argv[6])
+			atoi(argv[6]),
+			options
 		) << std::endl;
 		return 0;
 	}